@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/pendulum.h"
+#include "include/ensemble.h"
+#include "include/runner.h"
+
+// Microbenchmarks for the physics. Every row is one measurement as CSV,
+//
+//   benchmark,precision,isa,integrator,dt,items,seconds,rate,energy_error
+//
+// where rate is items per second (steps, derivative calls, or pendulum
+// steps for the ensemble) and energy_error is the relative energy error
+// after ACCURACY_TIME simulated seconds, or - for rows where that doesn't
+// mean anything. It comes from a separate run of a fixed length, so it only
+// changes between builds when the numbers actually do. Build it at each
+// precision (make bench, make bench PRECISION=double) and diff the output.
+//
+//   bench [-t seconds per measurement] [-j threads]
+
+#define GRAVITY 9.81f
+#define MIN_TIME 0.2 // seconds each measurement runs for at least
+#define REPEATS 3 // best of
+#define CHAIN_LINKS 64
+#define ENSEMBLE_COUNT 4096
+#define ACCURACY_TIME 20.0f // simulated seconds for the work-precision rows
+#define USAGE "usage: bench [-t seconds per measurement] [-j threads]\n"
+#define NO_ERROR -1.0 // what a run returns when it has no energy error to report
+
+typedef struct Bench {
+	const char *name;
+	Integrator integrator;
+	real dt;
+	double (*run)(const struct Bench *bench, long long items); // returns the energy error or NO_ERROR
+	void *ctx;
+} Bench;
+
+static volatile real sink; // keeps the optimizer from dropping the work
+
+static void getStart(Body *body0, Body *body1) {
+	*body0 = (Body){1, 1, 2.0f, 0};
+	*body1 = (Body){1, 1, 2.5f, 0};
+}
+
+static double relativeError(real energy, real initial) {
+	double e = (double)(energy - initial) / (double)initial;
+	return e < 0 ? -e : e;
+}
+
+static double runOmegadot(const Bench *bench, long long items) {
+	Body body0, body1;
+	getStart(&body0, &body1);
+	real sum = 0;
+	for (long long i = 0; i < items; ++i) {
+		body0.theta += 1e-6f;
+		sum += omegadot0(body0, body1, GRAVITY) + omegadot1(body0, body1, GRAVITY);
+	}
+	sink = sum;
+	return NO_ERROR;
+}
+
+static double runDerivative(const Bench *bench, long long items) {
+	Body body0, body1;
+	getStart(&body0, &body1);
+	DoubleParams params = getDoubleParams(body0, body1, GRAVITY);
+	real y[4], dydt[4], sum = 0;
+	packDouble(body0, body1, y);
+	for (long long i = 0; i < items; ++i) {
+		y[0] += 1e-6f;
+		doubleDerivative(y, dydt, &params);
+		sum += dydt[1] + dydt[3];
+	}
+	sink = sum;
+	return NO_ERROR;
+}
+
+static double runEnergy(const Bench *bench, long long items) {
+	Body body0, body1;
+	getStart(&body0, &body1);
+	real sum = 0;
+	for (long long i = 0; i < items; ++i) {
+		body0.theta += 1e-6f;
+		sum += getDoubleEnergy(body0, body1, GRAVITY);
+	}
+	sink = sum;
+	return NO_ERROR;
+}
+
+static double runDouble(const Bench *bench, long long items) {
+	Body body0, body1;
+	getStart(&body0, &body1);
+	real initial = getDoubleEnergy(body0, body1, GRAVITY);
+	for (long long i = 0; i < items; ++i) {
+		solveDouble(&body0, &body1, GRAVITY, bench->dt, bench->integrator);
+	}
+	return relativeError(getDoubleEnergy(body0, body1, GRAVITY), initial);
+}
+
+static double runSingle(const Bench *bench, long long items) {
+	Body body = {1, 1, 2.0f, 0};
+	real initial = getSingleEnergy(body, GRAVITY);
+	for (long long i = 0; i < items; ++i) {
+		solveSingle(&body, GRAVITY, bench->dt, bench->integrator);
+	}
+	return relativeError(getSingleEnergy(body, GRAVITY), initial);
+}
+
+static double runChain(const Bench *bench, long long items) {
+	Body bodies[CHAIN_LINKS];
+	for (int i = 0; i < CHAIN_LINKS; ++i) {
+		bodies[i] = (Body){1, 1, 0.3f, 0};
+	}
+	real initial = getChainEnergy(bodies, CHAIN_LINKS, GRAVITY);
+	for (long long i = 0; i < items; ++i) {
+		solveChain(bodies, CHAIN_LINKS, GRAVITY, bench->dt, bench->integrator);
+	}
+	return relativeError(getChainEnergy(bodies, CHAIN_LINKS, GRAVITY), initial);
+}
+
+// items is pendulum steps, so the rate compares directly with runDouble
+static double runEnsembleBench(const Bench *bench, long long items) {
+	Ensemble e = newEnsemble(ENSEMBLE_COUNT, GRAVITY);
+	Body body0, body1;
+	getStart(&body0, &body1);
+	for (int i = 0; i < ENSEMBLE_COUNT; ++i) {
+		body0.theta = 2.0f + 1e-4f * i;
+		setEnsembleBodies(&e, i, body0, body1);
+	}
+	long long steps = (items + ENSEMBLE_COUNT - 1) / ENSEMBLE_COUNT;
+	if (bench->ctx != NULL) {
+		runEnsemble((JobPool *)bench->ctx, &e, (float)bench->dt, (int)steps);
+	} else {
+		for (long long s = 0; s < steps; ++s) {
+			stepEnsemble(&e, (float)bench->dt);
+		}
+	}
+	sink = e.theta0[0];
+	freeEnsemble(&e);
+	return NO_ERROR;
+}
+
+static void printRow(const Bench *bench, long long items, double seconds, double error) {
+	// The ensemble lanes are float whatever the build, and a run that blew
+	// up prints nan the same way everywhere
+	const char *precision = (bench->run == runEnsembleBench) ? "float" : REAL_NAME;
+	printf("%s,%s,%s,%s,%g,%lld,%.6f,%.6g,", bench->name, precision, getEnsembleIsa(),
+		bench->integrator == INTEGRATOR_COUNT ? "-" : getIntegratorName(bench->integrator),
+		(double)bench->dt, items, seconds, items / seconds);
+	if (error == NO_ERROR) {
+		printf("-\n");
+	} else if (error == error) {
+		printf("%.6g\n", error);
+	} else {
+		printf("nan\n");
+	}
+	fflush(stdout);
+}
+
+// Doubles the item count until one run takes minTime, then keeps the best of REPEATS
+static void measure(const Bench *bench, double minTime) {
+	long long items = 256;
+	double seconds = 0;
+	double error = NO_ERROR;
+	for (;;) {
+		double start = getClock();
+		error = bench->run(bench, items);
+		seconds = getClock() - start;
+		if (seconds >= minTime) {
+			break;
+		}
+		items *= (seconds > 0 && minTime / seconds < 16) ? 2 : 16;
+	}
+	for (int r = 1; r < REPEATS; ++r) {
+		double start = getClock();
+		bench->run(bench, items);
+		double again = getClock() - start;
+		if (again < seconds) {
+			seconds = again;
+		}
+	}
+	// Runs with no error to report don't get the extra pass
+	if (error != NO_ERROR && bench->dt > 0) {
+		error = bench->run(bench, (long long)(ACCURACY_TIME / bench->dt));
+	}
+	printRow(bench, items, seconds, error);
+}
+
+// Fixed simulated time at a few dt, for error against cost curves
+static void measureAccuracy(Bench bench) {
+	const real dts[] = {0.01f, 0.003f, 0.001f, 0.0003f};
+	for (int i = 0; i < (int)(sizeof(dts) / sizeof(dts[0])); ++i) {
+		bench.dt = dts[i];
+		long long items = (long long)(ACCURACY_TIME / bench.dt);
+		double start = getClock();
+		double error = bench.run(&bench, items);
+		printRow(&bench, items, getClock() - start, error);
+	}
+}
+
+int main(int argc, char **argv) {
+	double minTime = MIN_TIME;
+	int threads = 0;
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 >= argc) {
+			fprintf(stderr, "%s needs a value\n" USAGE, argv[i]);
+			return 1;
+		}
+		if (strcmp(argv[i], "-t") == 0) {
+			minTime = atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			threads = atoi(argv[i + 1]);
+		} else {
+			fprintf(stderr, "unknown option %s\n" USAGE, argv[i]);
+			return 1;
+		}
+	}
+	JobPool *pool = newJobPool(threads);
+	if (pool == NULL) {
+		fprintf(stderr, "couldn't start the job pool\n");
+		return 1;
+	}
+
+	printf("benchmark,precision,isa,integrator,dt,items,seconds,rate,energy_error\n");
+	const real dt = 0.001f;
+	measure(&(Bench){"omegadot", INTEGRATOR_COUNT, 0, runOmegadot}, minTime);
+	measure(&(Bench){"derivative", INTEGRATOR_COUNT, 0, runDerivative}, minTime);
+	measure(&(Bench){"energy", INTEGRATOR_COUNT, 0, runEnergy}, minTime);
+	for (Integrator in = 0; in < INTEGRATOR_COUNT; ++in) {
+		measure(&(Bench){"single", in, dt, runSingle}, minTime);
+	}
+	for (Integrator in = 0; in < INTEGRATOR_COUNT; ++in) {
+		measure(&(Bench){"double", in, dt, runDouble}, minTime);
+	}
+	measure(&(Bench){"chain64", EULER, dt, runChain}, minTime);
+	measure(&(Bench){"chain64", RK4, dt, runChain}, minTime);
+	measure(&(Bench){"ensemble", RK4, dt, runEnsembleBench}, minTime);
+	measure(&(Bench){"ensemble_pool", RK4, dt, runEnsembleBench, pool}, minTime);
+	for (Integrator in = 0; in < INTEGRATOR_COUNT; ++in) {
+		measureAccuracy((Bench){"double_accuracy", in, 0, runDouble});
+	}
+
+	freeJobPool(pool);
+	return 0;
+}
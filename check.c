@@ -0,0 +1,181 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/pendulum.h"
+#include "include/scenario.h"
+#include "include/trajectory.h"
+
+// Regression checks for the physics and the file formats, run by make check.
+// Each check prints one line and the exit status is the number that failed.
+// The scenario loader complains on stderr about the bad numbers it's fed,
+// that's expected.
+// The tolerances hold at every PRECISION with room to spare, so a failure
+// means something actually changed.
+//
+//   check [directory for scratch files]
+
+#define GRAVITY 9.81f
+#define DT 0.001f
+#define DURATION 10.0f
+#define RK4_MAX_ERROR 1e-4 // relative energy error after DURATION
+#define RK45_MAX_ERROR 1e-4
+#define CHAIN_DURATION 2.0f // it's chaotic, so rounding differences blow up after a while
+#define CHAIN_MAX_DIFF 1e-3 // radians or radians per second
+#define TRAJ_FRAMES 5000
+#define TRAJ_DROP_EVERY 97 // frames, then a few steps go missing
+
+static int failures = 0;
+
+static void report(const char *name, int ok, const char *detail) {
+	printf("%s %s%s%s\n", ok ? "ok  " : "FAIL", name, detail[0] != '\0' ? ": " : "", detail);
+	failures += !ok;
+}
+
+static void getStart(Body *body0, Body *body1) {
+	*body0 = (Body){1, 1, 2.0f, 0};
+	*body1 = (Body){1, 1, 2.5f, 0};
+}
+
+static double getEnergyError(Integrator integrator) {
+	Body body0, body1;
+	getStart(&body0, &body1);
+	real initial = getDoubleEnergy(body0, body1, GRAVITY);
+	int steps = (int)(DURATION / DT + 0.5f);
+	for (int s = 0; s < steps; ++s) {
+		solveDouble(&body0, &body1, GRAVITY, DT, integrator);
+	}
+	return fabs((double)(getDoubleEnergy(body0, body1, GRAVITY) - initial) / (double)initial);
+}
+
+static void checkEnergy(void) {
+	char detail[64];
+	double rk4 = getEnergyError(RK4);
+	snprintf(detail, sizeof(detail), "%g after %g s", rk4, (double)DURATION);
+	report("RK4 energy", rk4 < RK4_MAX_ERROR, detail);
+	double rk45 = getEnergyError(RK45);
+	snprintf(detail, sizeof(detail), "%g after %g s", rk45, (double)DURATION);
+	report("RK45 energy", rk45 < RK45_MAX_ERROR, detail);
+}
+
+// Two links are the double pendulum, so the O(N) chain solver has to agree
+// with the closed form
+static void checkChain(void) {
+	Body body0, body1;
+	getStart(&body0, &body1);
+	body1.mass = 3;
+	body1.length = 0.5f;
+	Body chain[2] = {body0, body1};
+	double diff = 0;
+	int steps = (int)(CHAIN_DURATION / DT + 0.5f);
+	for (int s = 0; s < steps && diff < CHAIN_MAX_DIFF; ++s) {
+		solveDouble(&body0, &body1, GRAVITY, DT, RK4);
+		solveChain(chain, 2, GRAVITY, DT, RK4);
+		diff = fmax(fmax(fabs(chain[0].theta - body0.theta), fabs(chain[0].omega - body0.omega)),
+			fmax(fabs(chain[1].theta - body1.theta), fabs(chain[1].omega - body1.omega)));
+	}
+	char detail[64];
+	snprintf(detail, sizeof(detail), "largest difference %g", diff);
+	report("2 link chain vs double", diff < CHAIN_MAX_DIFF, detail);
+	report("chain past MAX_CHAIN", !solveChain(chain, MAX_CHAIN + 1, GRAVITY, DT, RK4), "");
+}
+
+static void checkTrajectory(const char *dir) {
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/check.traj", dir);
+	Body bodies[2];
+	getStart(&bodies[0], &bodies[1]);
+	Recorder *recorder = startRecorder(path, bodies, 2, GRAVITY, DT, RK4);
+	if (recorder == NULL) {
+		report("trajectory round trip", 0, "couldn't write the file");
+		return;
+	}
+	long long step = 1000;
+	for (int i = 0; i < TRAJ_FRAMES; ++i) {
+		step += (i % TRAJ_DROP_EVERY == TRAJ_DROP_EVERY - 1) ? 3 : 1;
+		bodies[0].theta = (real)i / 1024; // exact in a float, whatever real is
+		bodies[1].omega = (real)(-0.002 * i);
+		recordFrame(recorder, step * (double)DT, step, bodies, (float)i);
+	}
+	long long dropped = getRecorderDropped(recorder);
+	stopRecorder(recorder);
+
+	Trajectory traj;
+	if (!openTrajectory(&traj, path)) {
+		report("trajectory round trip", 0, "couldn't read the file back");
+		return;
+	}
+	int bad = traj.frameCount != TRAJ_FRAMES - dropped || traj.header->bodyCount != 2
+		|| traj.header->dt != DT || traj.mass[1] != bodies[1].mass || traj.length[0] != bodies[0].length;
+	for (long long n = 0; n < traj.frameCount && !bad; ++n) {
+		const TrajFrame *frame = getTrajFrame(&traj, n);
+		Body read[2];
+		getTrajBodies(&traj, n, read);
+		// Without drops frame n is what was recorded n-th
+		bad = dropped == 0 && (frame->energy != (float)n || read[0].theta != (real)n / 1024);
+		bad = bad || findTrajStep(&traj, frame->step) != n;
+		bad = bad || findTrajFrame(&traj, frame->time) != n;
+		bad = bad || findTrajFrame(&traj, frame->time + 0.5 * DT) != n;
+		if (n + 1 < traj.frameCount) {
+			// Missing steps land on the frame before them
+			bad = bad || findTrajStep(&traj, getTrajFrame(&traj, n + 1)->step - 1) != n;
+		}
+		bad = bad || read[1].mass != bodies[1].mass;
+	}
+	const TrajFrame *first = getTrajFrame(&traj, 0);
+	bad = bad || findTrajFrame(&traj, first->time - 1.0) != 0 || findTrajStep(&traj, 0) != 0
+		|| findTrajFrame(&traj, 1e12) != traj.frameCount - 1;
+	char detail[64];
+	snprintf(detail, sizeof(detail), "%lld frames, %lld dropped", traj.frameCount, dropped);
+	report("trajectory round trip", !bad, detail);
+	closeTrajectory(&traj);
+	remove(path);
+}
+
+// Scenario numbers go through a fast path that has to give exactly what
+// strtod does, and turn down whatever strtod would
+static void checkNumbers(const char *dir) {
+	static const char *inputs[] = {
+		"0", "-0", "+1", "0.25", "-3", "1.5e-3", "1E5", "2.", ".5", "-.5",
+		"123456789012345", "1234567890123456", "0.1", "3.1415927", "1e22", "1e23",
+		"1e-22", "1e-23", "4.9e-324", "1e308", "1e400", "0x10", "inf", "nan",
+		"1e", "1e+", "-", ".", "1.2.3", "12abc", "e5", "00012", "9007199254740993",
+	};
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/check.scn", dir);
+	int bad = 0;
+	for (int i = 0; i < (int)(sizeof(inputs) / sizeof(inputs[0])); ++i) {
+		FILE *file = fopen(path, "w");
+		if (file == NULL) {
+			report("numbers", 0, "couldn't write the scenario");
+			return;
+		}
+		fprintf(file, "body 1 1 0\nruns g\n%s\n", inputs[i]);
+		fclose(file);
+
+		char *end;
+		double expected = strtod(inputs[i], &end);
+		int valid = end != inputs[i] && *end == '\0';
+		Scenario scenario;
+		ScenarioFile *scn = openScenario(path, &scenario);
+		real value = 0;
+		int read = (scn != NULL) ? readScenarioRun(scn, &value) : -1;
+		closeScenario(scn);
+		if (valid ? read != 1 || memcmp(&value, &(real){(real)expected}, sizeof(real)) != 0 : read == 1) {
+			printf("     %s read as %.17g (%d), strtod says %.17g (%s)\n", inputs[i], (double)value,
+				read, expected, valid ? "valid" : "invalid");
+			bad++;
+		}
+	}
+	remove(path);
+	report("numbers against strtod", bad == 0, "");
+}
+
+int main(int argc, char **argv) {
+	const char *dir = (argc > 1) ? argv[1] : ".";
+	checkEnergy();
+	checkChain();
+	checkTrajectory(dir);
+	checkNumbers(dir);
+	return failures;
+}
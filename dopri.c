@@ -0,0 +1,229 @@
+#include "include/dopri.h"
+
+// Dormand-Prince tableau
+#define C2 ((real)(1.0 / 5.0))
+#define C3 ((real)(3.0 / 10.0))
+#define C4 ((real)(4.0 / 5.0))
+#define C5 ((real)(8.0 / 9.0))
+#define A21 ((real)(1.0 / 5.0))
+#define A31 ((real)(3.0 / 40.0))
+#define A32 ((real)(9.0 / 40.0))
+#define A41 ((real)(44.0 / 45.0))
+#define A42 ((real)(-56.0 / 15.0))
+#define A43 ((real)(32.0 / 9.0))
+#define A51 ((real)(19372.0 / 6561.0))
+#define A52 ((real)(-25360.0 / 2187.0))
+#define A53 ((real)(64448.0 / 6561.0))
+#define A54 ((real)(-212.0 / 729.0))
+#define A61 ((real)(9017.0 / 3168.0))
+#define A62 ((real)(-355.0 / 33.0))
+#define A63 ((real)(46732.0 / 5247.0))
+#define A64 ((real)(49.0 / 176.0))
+#define A65 ((real)(-5103.0 / 18656.0))
+#define A71 ((real)(35.0 / 384.0))
+#define A73 ((real)(500.0 / 1113.0))
+#define A74 ((real)(125.0 / 192.0))
+#define A75 ((real)(-2187.0 / 6784.0))
+#define A76 ((real)(11.0 / 84.0))
+
+// 5th order minus 4th order weights, for the error estimate
+#define E1 ((real)(71.0 / 57600.0))
+#define E3 ((real)(-71.0 / 16695.0))
+#define E4 ((real)(71.0 / 1920.0))
+#define E5 ((real)(-17253.0 / 339200.0))
+#define E6 ((real)(22.0 / 525.0))
+#define E7 ((real)(-1.0 / 40.0))
+
+// Dense output weights (Hairer & Wanner)
+#define D1 ((real)(-12715105075.0 / 11282082432.0))
+#define D3 ((real)(87487479700.0 / 32700410799.0))
+#define D4 ((real)(-10690763975.0 / 1880347072.0))
+#define D5 ((real)(701980252875.0 / 199316789632.0))
+#define D6 ((real)(-1453857185.0 / 822651844.0))
+#define D7 ((real)(69997945.0 / 29380423.0))
+
+#define SAFETY 0.9f
+#define MIN_SCALE 0.2f
+#define MAX_SCALE 5.0f
+
+void initDopri(Dopri *rk, Derivative f, const void *params, const real y0[], int dim,
+			  real tol, real h) {
+	rk->f = f;
+	rk->params = params;
+	rk->dim = dim;
+	rk->tol = tol;
+	rk->hMax = 0.0f;
+	rk->t = 0.0f;
+	rk->h = h;
+	for (int i = 0; i < dim; ++i) {
+		rk->y[i] = y0[i];
+		for (int j = 0; j < 5; ++j) {
+			rk->dense[j][i] = 0.0f;
+		}
+		rk->dense[0][i] = y0[i];
+	}
+	rk->f(rk->y, rk->k1, rk->params);
+	rk->tPrev = 0.0f;
+	rk->hPrev = 0.0f;
+	rk->evals = 1;
+	rk->accepted = 0;
+	rk->rejected = 0;
+}
+
+int stepDopri(Dopri *rk) {
+	int n = rk->dim;
+	real k2[DOPRI_MAX_DIM], k3[DOPRI_MAX_DIM], k4[DOPRI_MAX_DIM];
+	real k5[DOPRI_MAX_DIM], k6[DOPRI_MAX_DIM], k7[DOPRI_MAX_DIM];
+	real tmp[DOPRI_MAX_DIM], y1[DOPRI_MAX_DIM];
+	const real *y = rk->y;
+	const real *k1 = rk->k1;
+
+	for (int rejects = 0;; ++rejects) {
+		real h = rk->h;
+		if (rejects >= DOPRI_MAX_REJECTS || h <= DOPRI_MIN_STEP * REAL_EPSILON * realAbs(rk->t)) {
+			return 0;
+		}
+		if (rk->hMax > 0.0f && h > rk->hMax) {
+			h = rk->hMax;
+		}
+
+		for (int i = 0; i < n; ++i) tmp[i] = y[i] + h * A21 * k1[i];
+		rk->f(tmp, k2, rk->params);
+		for (int i = 0; i < n; ++i) tmp[i] = y[i] + h * (A31 * k1[i] + A32 * k2[i]);
+		rk->f(tmp, k3, rk->params);
+		for (int i = 0; i < n; ++i) tmp[i] = y[i] + h * (A41 * k1[i] + A42 * k2[i] + A43 * k3[i]);
+		rk->f(tmp, k4, rk->params);
+		for (int i = 0; i < n; ++i) {
+			tmp[i] = y[i] + h * (A51 * k1[i] + A52 * k2[i] + A53 * k3[i] + A54 * k4[i]);
+		}
+		rk->f(tmp, k5, rk->params);
+		for (int i = 0; i < n; ++i) {
+			tmp[i] = y[i] + h * (A61 * k1[i] + A62 * k2[i] + A63 * k3[i] + A64 * k4[i] + A65 * k5[i]);
+		}
+		rk->f(tmp, k6, rk->params);
+		for (int i = 0; i < n; ++i) {
+			y1[i] = y[i] + h * (A71 * k1[i] + A73 * k3[i] + A74 * k4[i] + A75 * k5[i] + A76 * k6[i]);
+		}
+		rk->f(y1, k7, rk->params);
+		rk->evals += 6;
+
+		// RMS of the error relative to the tolerance, 1 means right at it
+		real err = 0.0f;
+		for (int i = 0; i < n; ++i) {
+			real e = h * (E1 * k1[i] + E3 * k3[i] + E4 * k4[i] + E5 * k5[i] + E6 * k6[i] + E7 * k7[i]);
+			real scale = rk->tol * (1.0f + realMax(realAbs(y[i]), realAbs(y1[i])));
+			err += (e / scale) * (e / scale);
+		}
+		err = realSqrt(err / n);
+
+		// A NaN or infinite error is as bad as it gets, not a free pass
+		real factor = !isfinite(err) ? MIN_SCALE : (err > 0.0f) ? SAFETY * realPow(err, -0.2f) : MAX_SCALE;
+		factor = realMin(MAX_SCALE, realMax(MIN_SCALE, factor));
+
+		if (!(err <= 1.0f)) {
+			rk->h = h * realMin(1.0f, factor);
+			rk->rejected++;
+			continue;
+		}
+
+		// Accepted, so save the interpolant before moving on
+		for (int i = 0; i < n; ++i) {
+			real diff = y1[i] - y[i];
+			real bspl = h * k1[i] - diff;
+			rk->dense[0][i] = y[i];
+			rk->dense[1][i] = diff;
+			rk->dense[2][i] = bspl;
+			rk->dense[3][i] = diff - h * k7[i] - bspl;
+			rk->dense[4][i] = h * (D1 * k1[i] + D3 * k3[i] + D4 * k4[i]
+				+ D5 * k5[i] + D6 * k6[i] + D7 * k7[i]);
+		}
+		for (int i = 0; i < n; ++i) {
+			rk->y[i] = y1[i];
+			rk->k1[i] = k7[i];
+		}
+		rk->tPrev = rk->t;
+		rk->hPrev = h;
+		rk->t += h;
+		rk->h = h * factor;
+		rk->accepted++;
+		return 1;
+	}
+}
+
+int advanceDopri(Dopri *rk, real tEnd) {
+	while (rk->t < tEnd) {
+		if (!stepDopri(rk)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// s is the fraction of the last step, 0 at tPrev and 1 at t
+static void interpolate(const Dopri *rk, real s, real y[]) {
+	real s1 = 1.0f - s;
+	for (int i = 0; i < rk->dim; ++i) {
+		y[i] = rk->dense[0][i] + s * (rk->dense[1][i] + s1 * (rk->dense[2][i]
+			+ s * (rk->dense[3][i] + s1 * rk->dense[4][i])));
+	}
+}
+
+void denseDopri(const Dopri *rk, real t, real y[]) {
+	if (rk->hPrev <= 0.0f) {
+		for (int i = 0; i < rk->dim; ++i) {
+			y[i] = rk->y[i];
+		}
+		return;
+	}
+	interpolate(rk, (t - rk->tPrev) / rk->hPrev, y);
+}
+
+void initDopriEvent(DopriEvent *event, EventFn fn, const void *ctx, int direction, const Dopri *rk) {
+	event->fn = fn;
+	event->ctx = ctx;
+	event->direction = direction;
+	event->last = fn(rk->y, ctx);
+}
+
+int locateDopriEvent(DopriEvent *event, const Dopri *rk, real *t, real y[]) {
+	real ga = event->last;
+	real gb = event->fn(rk->y, event->ctx);
+	event->last = gb;
+	int rising = ga < 0.0f && gb >= 0.0f;
+	int falling = ga > 0.0f && gb <= 0.0f;
+	if (!((rising && event->direction >= 0) || (falling && event->direction <= 0))) {
+		return 0;
+	}
+
+	// Illinois method: regula falsi, but halving the value at an end that
+	// has been kept twice in a row so the bracket closes from both sides.
+	// It works on the fraction of the step, t itself may be too coarse.
+	real a = 0.0f, b = 1.0f, s = 1.0f;
+	int kept = 0;
+	for (int i = 0; i < EVENT_MAX_ITER && b - a > 4 * REAL_EPSILON; ++i) {
+		s = (a * gb - b * ga) / (gb - ga);
+		interpolate(rk, s, y);
+		real g = event->fn(y, event->ctx);
+		if (g == 0.0f) {
+			break;
+		}
+		if ((g > 0.0f) == (gb > 0.0f)) {
+			b = s;
+			gb = g;
+			if (kept == -1) {
+				ga *= 0.5f;
+			}
+			kept = -1;
+		} else {
+			a = s;
+			ga = g;
+			if (kept == 1) {
+				gb *= 0.5f;
+			}
+			kept = 1;
+		}
+	}
+	interpolate(rk, s, y);
+	*t = rk->tPrev + s * rk->hPrev;
+	return 1;
+}
@@ -1,20 +1,30 @@
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #ifndef RAYLIB_H
 #include "include/raylib.h"
 #include "include/raymath.h"
 #endif
 #include "include/ui.h"
+#include "include/pendulum.h"
+#include "include/simthread.h"
+#include "include/lyapunov.h"
+#include "include/runner.h"
+#include "include/ensemble_view.h"
+#include "include/trajectory.h"
+#include "include/trace.h"
+#include "include/export.h"
+#include "include/scenario.h"
 
-#define GRAVITY (200.0f) // this just worked best
 #define MIN_RADIUS 4
 #define MAX_RADIUS 40
-#define MAX_SPEED 16.0f
+#define MAX_SPEED 131072.0f // time warp, see include/simthread.h
 #define MIN_SPEED 0.0625f
 #define MIN_MASS 1
 #define MAX_MASS 1000
 #define MIN_LENGTH 10
 #define MAX_LENGTH 250
-#define ONE_SIXTH 0.16666667f
 
 #define SLIDER_LEN 150
 #define ROW_WIDTH 600
@@ -24,20 +34,27 @@
 #define TABLE_FONT_SZ 24
 #define TABLE_SLIDER_OFFSET 400
 
-#define RK4 1
+#define SCENARIO_PATH "scenarios/double.scn" // starting state and integrator (I cycles through the rest), -scenario picks another
+#define RECORD_PATH "double_pendulum.traj"
+#define TRACE_PATH "double_pendulum.trace.json" // T starts and stops a trace
+#define LYAPUNOV_STEPS_PER_FRAME 1024
+#define TRAIL_POINTS 100000 // physics steps of the second bob, about 7 minutes at 240 Hz, L shows or hides it
+#define TRAIL_COLOR SKYBLUE
+#define ENSEMBLE_SIDE 100 // E shows a grid of side^2 pendulums around the current one, unless the scenario says otherwise
+#define ENSEMBLE_SPREAD 0.01f // radians across the grid, in each angle
+#define ENSEMBLE_MAX_STEPS 16 // per frame, past that the ensemble falls behind
+#define EXPORT_FPS 60 // -export, -raw or -pipe renders frames without a window, see include/export.h
+#define EXPORT_SECONDS 10.0f
+#define EXPORT_TRAIL 1200 // physics steps
+#define PROFILER_X 1420
+#define PROFILER_Y 780
 
 typedef enum State {
 	STOP,
-	RUN
+	RUN,
+	REPLAY // scrubbing through the last recording
 } State;
 
-typedef struct Body {
-	float mass; // in kilograms
-	float length; // in meters
-	float theta; // angle in radians
-	float omega; // radians per second
-} Body;
-
 typedef struct StartBtnState {
 	State *simState;
 	Button *button;
@@ -52,26 +69,67 @@ typedef struct TableRow {
 } TableRow;
 
 void render(Body body0, Body body1, Vector2 origin);
-void solve(Body *body0, Body *body1, float dt);
-
 Vector2 getPos(Body body);
-float getEnergy(Body body0, Body body1);
 
-// Functions for RK4
-float omegadot0(Body body0, Body body1);
-float thetadot0(Body body0, Body body1);
-float omegadot1(Body body0, Body body1);
-float thetadot1(Body body0, Body body1);
+void resetEnsemble(Ensemble *ensemble, EnsembleView *view, Body body0, Body body1, int side, float spread);
 
 void startSim(void *state);
-TableRow newTableRow(int posX, int posY);
+TableRow newTableRow(int posX, int posY, Body body);
 void drawTableRow(Body body, TableRow tableRow, int id);
 
-int main(void) {
+int main(int argc, char **argv) {
 	const Vector2 screenSize = {1920, 1080};
 	const char *screenName = "N-Body Pendulum";
 	const int targetFPS = 60;
 
+	const char *scenarioPath = SCENARIO_PATH;
+	if (argc >= 3 && strcmp(argv[1], "-scenario") == 0) {
+		scenarioPath = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+	Scenario scenario;
+	if (!loadScenario(scenarioPath, &scenario)) {
+		return 1;
+	}
+	if (scenario.count != 2) {
+		fprintf(stderr, "%s: the double pendulum needs exactly two bodies\n", scenarioPath);
+		return 1;
+	}
+	const real g = scenario.g;
+	const float dt = scenario.dt;
+	const int ensembleSide = scenario.ensembleSide >= 2 ? scenario.ensembleSide : ENSEMBLE_SIDE;
+	const float ensembleSpread = scenario.ensembleSide >= 2 ? scenario.ensembleSpread : ENSEMBLE_SPREAD;
+
+	Body body0 = scenario.bodies[0];
+	Body body1 = scenario.bodies[1];
+
+	float radius[2] = {
+		Lerp(MIN_RADIUS, MAX_RADIUS, Normalize(body0.mass, MIN_MASS, MAX_MASS)),
+		Lerp(MIN_RADIUS, MAX_RADIUS, Normalize(body1.mass, MIN_MASS, MAX_MASS)),
+	};
+	ExportOptions export = {
+		.width = screenSize.x,
+		.height = screenSize.y,
+		.fps = EXPORT_FPS,
+		.duration = EXPORT_SECONDS,
+		.trail = EXPORT_TRAIL,
+		.bodies = (Body[]){body0, body1},
+		.count = 2,
+		.g = g,
+		.dt = dt,
+		.integrator = scenario.integrator,
+		.pivotRadius = 5,
+		.radius = radius,
+	};
+	int exporting = parseExportArgs(argc, argv, &export);
+	if (exporting != 0) {
+		export.originX = export.width / 2.0f;
+		export.originY = export.height / 2.0f;
+		export.scale = export.height / screenSize.y;
+		return exporting < 0 || runExport(&export) < 0;
+	}
+
 	SetConfigFlags(FLAG_WINDOW_ALWAYS_RUN);
 	//SetConfigFlags(FLAG_FULLSCREEN_MODE);
 	SetConfigFlags(FLAG_VSYNC_HINT);
@@ -84,23 +142,70 @@ int main(void) {
 
 	Vector2 origin = (Vector2){screenSize.x / 2, screenSize.y / 2};
 
-	Body body0 = (Body){10, 100, 0.4f * PI, 0};
-	Body body1 = (Body){5, 100, 0.8f * PI, 0};
+	Body prev0 = body0;
+	Body prev1 = body1;
+	float alpha = 1.0f;
+	real simTime = 0.0f;
 
-	float initialEnergy = getEnergy(body0, body1);
+	// Steps on its own thread at its own rate, so vsync doesn't hold it back
+	SimThread *sim = startSimThread((Body[]){body0, body1}, 2, g, dt, scenario.integrator);
+	if (sim == NULL) {
+		CloseWindow();
+		return 1;
+	}
+
+	// Runs its own RK4 copy of the pendulum alongside whatever is shown,
+	// carrying the tangent vectors the exponents come from
+	Lyapunov lyapunov;
+	initLyapunov(&lyapunov, body0, body1, g);
+
+	Recorder *recorder = NULL;
+	Trajectory replay = {0};
+	float replayTime = 0.0f;
+	bool replayPaused = false;
+	Slider scrubSlider = newSlider(0.0f, 360, 1000, 1200);
+
+	Trail trail = newTrail(TRAIL_POINTS, TRAIL_COLOR);
+	bool showTrail = true;
+	long long trailEnd = 0; // pathEnd of the last frame the trail took points from
+
+	// Stepped on a job pool on this thread, only while it's shown
+	Ensemble ensemble = newEnsemble(ensembleSide * ensembleSide, g);
+	EnsembleView ensembleView = newEnsembleView(ensemble.count);
+	JobPool *pool = newJobPool(0);
+	FixedStep ensembleClock = newFixedStep(dt, ENSEMBLE_MAX_STEPS);
+	Body ensembleStart[2] = {0}; // what the ensemble was last spread around
+	bool showEnsemble = false;
+	bool canShowEnsemble = ensemble.theta0 != NULL && ensembleView.meshes != NULL && pool != NULL;
+
+	real initialEnergy = getDoubleEnergy(body0, body1, g);
 
 	Button startBtn = newButton(0.5f * (GetScreenWidth() - 160), 50, 160, 50, 
 							 0.5f, GREEN, DARKGREEN, "Start", &startSim);
-	TableRow row0 = newTableRow(1200, 50);
-	TableRow row1 = newTableRow(1200, 50 + ROW_HEIGHT);
+	TableRow row0 = newTableRow(1200, 50, body0);
+	TableRow row1 = newTableRow(1200, 50 + ROW_HEIGHT, body1);
+	bool slidersMoved = false; // until then STOP keeps the scenario's bodies, speeds and all
 
 	State simState = STOP;
+	State simThreadState = STOP; // last state the physics thread was told about
+	Integrator integrator = scenario.integrator;
+
+#ifdef PENDULUM_PROFILE
+	bool showProfiler = false;
+#endif
+
+	setTraceThreadName("main");
 
 	while (!WindowShouldClose()) {
-		float dt = GetFrameTime();
+		PROFILE_FRAME();
+		PROFILE_BEGIN(PHASE_INPUT);
+		TRACE_BEGIN("frame");
+		TRACE_BEGIN("input");
 		KeyboardKey key = GetKeyPressed();
 
-		handleButton(&startBtn, &(StartBtnState){&simState, &startBtn});
+		if (simState != REPLAY) {
+			handleButton(&startBtn, &(StartBtnState){&simState, &startBtn});
+		}
 
 		if (simState == STOP) {
 			updateSlider(&row0.massSlider);
@@ -109,9 +214,14 @@ int main(void) {
 			updateSlider(&row1.massSlider);
 			updateSlider(&row1.lengthSlider);
 			updateSlider(&row1.thetaSlider);
+			slidersMoved = slidersMoved || row0.massSlider.isDragging || row0.lengthSlider.isDragging
+				|| row0.thetaSlider.isDragging || row1.massSlider.isDragging
+				|| row1.lengthSlider.isDragging || row1.thetaSlider.isDragging;
 		}
 
-		if (key == KEY_SPACE) {
+		if (key == KEY_SPACE && simState == REPLAY) {
+			replayPaused = !replayPaused;
+		} else if (key == KEY_SPACE) {
 			if (simState == STOP) {
 				simState = RUN;
 				startBtn.bgColor = RED;
@@ -127,41 +237,204 @@ int main(void) {
 
 		if (key == KEY_RIGHT && speedup < MAX_SPEED) {
 			speedup *= 2.0f;
+			setSimSpeed(sim, speedup);
 		} else if (key == KEY_LEFT && speedup > MIN_SPEED) {
 			speedup *= 0.5f;
+			setSimSpeed(sim, speedup);
 		}
 
-		// Numerically integrate to solve the system according to the
-		// differential equation given by the Euler-Lagrange equation
+		if (key == KEY_L) {
+			showTrail = !showTrail;
+		}
+
+		if (key == KEY_E && canShowEnsemble) {
+			showEnsemble = !showEnsemble;
+			if (showEnsemble) {
+				resetEnsemble(&ensemble, &ensembleView, body0, body1, ensembleSide, ensembleSpread);
+				ensembleStart[0] = body0;
+				ensembleStart[1] = body1;
+				ensembleClock.accumulator = 0.0f;
+			}
+		}
+
+		if (key == KEY_I) {
+			integrator = (integrator + 1) % INTEGRATOR_COUNT;
+			setSimIntegrator(sim, integrator);
+		}
+
+		if (key == KEY_P && simState != REPLAY) {
+			stopRecorder(setSimRecorder(sim, NULL));
+			recorder = NULL;
+			if (openTrajectory(&replay, RECORD_PATH) && replay.frameCount > 0) {
+				simState = REPLAY;
+				replayTime = 0.0f;
+				replayPaused = false;
+				clearTrail(&trail);
+				initialEnergy = getTrajFrame(&replay, 0)->energy;
+			} else {
+				closeTrajectory(&replay);
+			}
+		} else if (key == KEY_P) {
+			closeTrajectory(&replay);
+			simState = STOP;
+			startBtn.bgColor = GREEN;
+			startBtn.borderColor = DARKGREEN;
+			startBtn.text = "Start";
+		}
+
+		// A recording covers one run. Time and steps start over at every
+		// reset and the sliders can change the bodies, so it's only started
+		// while running and ends when the run does.
+		if (key == KEY_R && simState == RUN) {
+			if (recorder == NULL) {
+				recorder = startRecorder(RECORD_PATH, (Body[]){body0, body1}, 2,
+										 g, integrator == RK45 ? 0.0f : dt, integrator);
+				setSimRecorder(sim, recorder);
+			} else {
+				stopRecorder(setSimRecorder(sim, NULL));
+				recorder = NULL;
+			}
+		}
+
+#ifdef PENDULUM_PROFILE
+		if (key == KEY_F3) {
+			showProfiler = !showProfiler;
+		}
+#endif
+		if (key == KEY_T) {
+			if (!traceEnabled) {
+				startTrace();
+			} else {
+				stopTrace(TRACE_PATH);
+			}
+		}
+		if (simState != simThreadState) {
+			if (simState != RUN && recorder != NULL) {
+				stopRecorder(setSimRecorder(sim, NULL));
+				recorder = NULL;
+			}
+			setSimRunning(sim, simState == RUN);
+			simThreadState = simState;
+		}
+		PROFILE_END(PHASE_INPUT);
+		TRACE_END("input");
+		PROFILE_BEGIN(PHASE_PHYSICS);
+		TRACE_BEGIN("physics");
+
+		// The physics thread numerically integrates the differential
+		// equation given by the Euler-Lagrange equation with a fixed step, so
+		// this only has to pick up the latest state it has published
+		const SimFrame *frame = readSimFrame(sim);
 		if (simState == RUN) {
-			if (speedup > 1.0f - EPSILON) {
-				int steps = (int)(speedup + EPSILON);
-				for (int i = 0; i < steps; ++i) {
-					solve(&body0, &body1, dt);
+			prev0 = frame->prev[0];
+			prev1 = frame->prev[1];
+			body0 = frame->bodies[0];
+			body1 = frame->bodies[1];
+			alpha = frame->alpha;
+			simTime = frame->time;
+			// One point per physics step, so it stays the real trace at any warp
+			long long first = frame->pathEnd - frame->pathCount;
+			for (int i = 0; i < frame->pathCount; ++i) {
+				if (first + i >= trailEnd) {
+					pushTrail(&trail, Vector2Add(origin, (Vector2){frame->pathX[i], frame->pathY[i]}));
 				}
-			} else {
-				solve(&body0, &body1, dt * speedup);
 			}
+		}
+		trailEnd = frame->pathEnd;
+		if (simState == RUN && showEnsemble) {
+			int steps = advanceFixedStep(&ensembleClock, GetFrameTime(), speedup);
+			if (steps > 0) {
+				runEnsemble(pool, &ensemble, dt, steps);
+			}
+		}
+		if (simState == RUN) {
+			// Capped so a big warp can't stall the frame, the exponents just
+			// come from a shorter stretch of the run
+			for (int i = 0; i < LYAPUNOV_STEPS_PER_FRAME && lyapunov.time + dt <= simTime; ++i) {
+				stepLyapunov(&lyapunov, dt);
+			}
+		}
+		if (simState == REPLAY) {
+			// Frames are looked up directly, so scrubbing anywhere is as cheap as playing
+			float duration = (float)getTrajDuration(&replay);
+			if (!replayPaused) {
+				replayTime = fminf(replayTime + fminf(GetFrameTime(), MAX_FRAME_TIME) * speedup, duration);
+			}
+			float shown = (duration > 0.0f) ? replayTime / duration : 0.0f;
+			scrubSlider.value = shown;
+			updateSlider(&scrubSlider);
+			if (scrubSlider.value != shown) {
+				replayTime = scrubSlider.value * duration;
+				clearTrail(&trail);
+			}
+
+			Body bodies[2];
+			double start = getTrajFrame(&replay, 0)->time;
+			getTrajBodies(&replay, findTrajFrame(&replay, start + replayTime), bodies);
+			body0 = prev0 = bodies[0];
+			body1 = prev1 = bodies[1];
+			alpha = 1.0f;
 		} else if (simState == STOP) {
-			initialEnergy = getEnergy(body0, body1);
+			initialEnergy = getDoubleEnergy(body0, body1, g);
+			clearTrail(&trail);
+
+			if (slidersMoved) {
+				body0.mass = Lerp(MIN_MASS, MAX_MASS, row0.massSlider.value);
+				body0.length = Lerp(MIN_LENGTH, MAX_LENGTH, row0.lengthSlider.value);
+				body0.theta = 2.0f * PI * row0.thetaSlider.value;
+				body0.omega = 0.0f;
+
+				body1.mass = Lerp(MIN_MASS, MAX_MASS, row1.massSlider.value);
+				body1.length = Lerp(MIN_LENGTH, MAX_LENGTH, row1.lengthSlider.value);
+				body1.theta = 2.0f * PI * row1.thetaSlider.value;
+				body1.omega = 0.0f;
+			} else {
+				body0 = scenario.bodies[0];
+				body1 = scenario.bodies[1];
+			}
 
-			body0.mass = Lerp(MIN_MASS, MAX_MASS, row0.massSlider.value);
-			body0.length = Lerp(MIN_LENGTH, MAX_LENGTH, row0.lengthSlider.value);
-			body0.theta = 2.0f * PI * row0.thetaSlider.value;
-			body0.omega = 0.0f;
+			prev0 = body0;
+			prev1 = body1;
+			alpha = 1.0f;
 
-			body1.mass = Lerp(MIN_MASS, MAX_MASS, row1.massSlider.value);
-			body1.length = Lerp(MIN_LENGTH, MAX_LENGTH, row1.lengthSlider.value);
-			body1.theta = 2.0f * PI * row1.thetaSlider.value;
-			body1.omega = 0.0f;
+			resetSim(sim, (Body[]){body0, body1});
+			if (showEnsemble && memcmp(ensembleStart, (Body[]){body0, body1}, sizeof(ensembleStart)) != 0) {
+				resetEnsemble(&ensemble, &ensembleView, body0, body1, ensembleSide, ensembleSpread);
+				ensembleStart[0] = body0;
+				ensembleStart[1] = body1;
+				ensembleClock.accumulator = 0.0f;
+			}
+			initLyapunov(&lyapunov, body0, body1, g);
+			simTime = 0.0f;
 		}
-		float energy = getEnergy(body0, body1);
+		real energy = getDoubleEnergy(body0, body1, g);
+		PROFILE_END(PHASE_PHYSICS);
+		TRACE_END("physics");
+		TRACE_COUNTER("energy drift %", 100.0 * (energy - initialEnergy) / initialEnergy);
 
+		// EndDrawing isn't in any phase, it waits for vsync
 		BeginDrawing(); {
+			PROFILE_BEGIN(PHASE_RENDER);
+			TRACE_BEGIN("render");
 			ClearBackground(BLACK);
 
 			// Draw the system
-			render(body0, body1, origin);
+			if (showEnsemble && simState != REPLAY) {
+				drawEnsembleView(&ensembleView, &ensemble, origin);
+			}
+			Body draw0 = interpolateBody(prev0, body0, alpha);
+			Body draw1 = interpolateBody(prev1, body1, alpha);
+			if (simState == REPLAY) {
+				pushTrail(&trail, Vector2Add(Vector2Add(origin, getPos(draw0)), getPos(draw1)));
+			}
+			if (showTrail) {
+				drawTrail(trail);
+			}
+			render(draw0, draw1, origin);
+			PROFILE_END(PHASE_RENDER);
+			TRACE_END("render");
+			PROFILE_BEGIN(PHASE_UI);
+			TRACE_BEGIN("ui");
 
 			// Speedup text
 			const char *speedupText = (speedup >= 1 - EPSILON)
@@ -169,22 +442,74 @@ int main(void) {
 				: TextFormat("Speed: 1/%dX", (int)(1.0f / speedup));
 			float textWidth = MeasureText(speedupText, 36);
 			DrawText(speedupText, 0.5f * (GetScreenWidth() - textWidth), 120, 36, WHITE);
+			if (simState == RUN && frame->warp > 0.0f && frame->warp < 0.99f * frame->speedup) {
+				// The physics thread couldn't fit the requested warp in its budget
+				const char *warpText = TextFormat("achieved %.0fX", frame->warp);
+				DrawText(warpText, 0.5f * (GetScreenWidth() - MeasureText(warpText, 24)), 160, 24, YELLOW);
+			}
 
 			// Energy text
 			DrawText(TextFormat("Initial energy: %d", (int)initialEnergy), 20, 40, 24, WHITE);
 			DrawText(TextFormat("Current energy: %d", (int)energy), 20, 80, 24, WHITE);
-			float percentDiff = 100.0f * (energy - initialEnergy) / initialEnergy;
+			real percentDiff = 100.0f * (energy - initialEnergy) / initialEnergy;
 			DrawText(TextFormat("Energy change: %f%%", percentDiff), 20, 120, 24, WHITE);
+			if (frame->integrator != integrator && simState == RUN) {
+				DrawText(TextFormat("Integrator: %s (I), %s for the warp", getIntegratorName(integrator),
+					getIntegratorName(frame->integrator)), 20, 160, 24, YELLOW);
+			} else {
+				DrawText(TextFormat("Integrator: %s (I)", getIntegratorName(integrator)), 20, 160, 24, WHITE);
+			}
+			if (recorder != NULL) {
+				DrawText(TextFormat("Recording: %lld frames, %lld dropped (R)", getRecorderFrames(recorder),
+					getRecorderDropped(recorder)), 20, 200, 24, RED);
+			} else if (simState == RUN) {
+				DrawText("Record (R), replay (P), trail (L), ensemble (E)", 20, 200, 24, WHITE);
+			} else if (simState == STOP) {
+				DrawText("Replay (P), trail (L), ensemble (E)", 20, 200, 24, WHITE);
+			}
+			if (simState != REPLAY) {
+				real spectrum[LYAPUNOV_DIM];
+				getLyapunovSpectrum(&lyapunov, spectrum);
+				DrawText(TextFormat("Lyapunov: %.3f %.3f %.3f %.3f /s", spectrum[0], spectrum[1],
+					spectrum[2], spectrum[3]), 20, 240, 24, WHITE);
+			}
 
 			// UI
-			drawButton(startBtn, font);
+			if (simState == REPLAY) {
+				DrawText(TextFormat("Replay: %.2f / %.2f s%s (P to exit)", replayTime, getTrajDuration(&replay),
+					replayPaused ? ", paused" : ""), 360, 950, 24, WHITE);
+				drawSlider(scrubSlider);
+			} else {
+				drawButton(startBtn, font);
+			}
 			if (simState == STOP) {
 				drawTableRow(body0, row0, 0);
 				drawTableRow(body1, row1, 1);
 			}
+			if (traceEnabled) {
+				DrawText("Tracing (T)", 20, 280, 24, RED);
+			}
+			PROFILE_END(PHASE_UI);
+			TRACE_END("ui");
+#ifdef PENDULUM_PROFILE
+			if (showProfiler) {
+				drawProfiler(PROFILER_X, PROFILER_Y);
+			}
+#endif
 		} EndDrawing();
+		TRACE_END("frame");
 	}
 
+	if (traceEnabled) {
+		stopTrace(TRACE_PATH);
+	}
+	stopSimThread(sim);
+	stopRecorder(recorder);
+	closeTrajectory(&replay);
+	freeTrail(&trail);
+	freeEnsembleView(&ensembleView);
+	freeEnsemble(&ensemble);
+	freeJobPool(pool);
 	CloseWindow();
 
 	return 0;
@@ -200,106 +525,6 @@ void render(Body body0, Body body1, Vector2 origin) {
 	DrawCircleV(pos1, Lerp(MIN_RADIUS, MAX_RADIUS, Normalize(body1.mass, MIN_MASS, MAX_MASS)), BLUE);
 }
 
-void solve(Body *body0, Body *body1, float dt) {
-	#if RK4
-
-	Body b0_1 = (Body){body0->mass, body0->length, body0->theta, body0->omega};
-	Body b1_1 = (Body){body1->mass, body1->length, body1->theta, body1->omega};
-	float d_omega0_1 = omegadot0(b0_1, b1_1);
-	float d_theta0_1 = thetadot0(b0_1, b1_1);
-	float d_omega1_1 = omegadot1(b0_1, b1_1);
-	float d_theta1_1 = thetadot1(b0_1, b1_1);
-
-	Body b0_2 = (Body){body0->mass, body0->length, 
-		body0->theta + 0.5f * dt * d_theta0_1, 
-		body0->omega + 0.5f * dt * d_omega0_1};
-	Body b1_2 = (Body){body1->mass, body1->length, 
-		body1->theta + 0.5f * dt * d_theta1_1, 
-		body1->omega + 0.5f * dt * d_omega1_1};
-	float d_omega0_2 = omegadot0(b0_2, b1_2);
-	float d_theta0_2 = thetadot0(b0_2, b1_2);
-	float d_omega1_2 = omegadot1(b0_2, b1_2);
-	float d_theta1_2 = thetadot1(b0_2, b1_2);
-
-	Body b0_3 = (Body){body0->mass, body0->length, 
-		body0->theta + 0.5f * dt * d_theta0_2, 
-		body0->omega + 0.5f * dt * d_omega0_2};
-	Body b1_3 = (Body){body1->mass, body1->length, 
-		body1->theta + 0.5f * dt * d_theta1_2, 
-		body1->omega + 0.5f * dt * d_omega1_2};
-	float d_omega0_3 = omegadot0(b0_3, b1_3);
-	float d_theta0_3 = thetadot0(b0_3, b1_3);
-	float d_omega1_3 = omegadot1(b0_3, b1_3);
-	float d_theta1_3 = thetadot1(b0_3, b1_3);
-
-	Body b0_4 = (Body){body0->mass, body0->length, 
-		body0->theta + dt * d_theta0_3, 
-		body0->omega + dt * d_omega0_3};
-	Body b1_4 = (Body){body1->mass, body1->length, 
-		body1->theta + dt * d_theta1_3, 
-		body1->omega + dt * d_omega1_3};
-	float d_omega0_4 = omegadot0(b0_4, b1_4);
-	float d_theta0_4 = thetadot0(b0_4, b1_4);
-	float d_omega1_4 = omegadot1(b0_4, b1_4);
-	float d_theta1_4 = thetadot1(b0_4, b1_4);
-
-	body0->omega += ONE_SIXTH * dt * (d_omega0_1 + 2*d_omega0_2 + 2*d_omega0_3 + d_omega0_4);
-	body0->theta += ONE_SIXTH * dt * (d_theta0_1 + 2*d_theta0_2 + 2*d_theta0_3 + d_theta0_4);
-	body1->omega += ONE_SIXTH * dt * (d_omega1_1 + 2*d_omega1_2 + 2*d_omega1_3 + d_omega1_4);
-	body1->theta += ONE_SIXTH * dt * (d_theta1_1 + 2*d_theta1_2 + 2*d_theta1_3 + d_theta1_4);
-
-	#else
-	
-	body->theta += dt * body->omega;
-	body->omega += dt * func(body->theta, body->length);
-
-	#endif
-
-	return;
-}
-
-float omegadot0(Body body0, Body body1) {
-	// This formula is so long, that this makes sense
-	float m0 = body0.mass;
-	float m1 = body1.mass;
-	float l0 = body0.length;
-	float l1 = body1.length;
-	float t0 = body0.theta;
-	float t1 = body1.theta;
-	float w0 = body0.omega;
-	float w1 = body1.omega;
-	float g = GRAVITY;
-
-	return (m1 * cosf(t0 - t1) * (l0 * w0 * w0 * sinf(t1 - t0) + g * sinf(t1))
-		- (m1 * l1 * w1 * w1 * sinf(t0 - t1) + (m0 + m1) * g * sinf(t0))) 
-		/ (l0 * (m0 + m1 * sinf(t0 - t1) * sinf(t0-t1)));
-}
-
-float thetadot0(Body body0, Body body1) {
-	return body0.omega;
-}
-
-float omegadot1(Body body0, Body body1) {
-	// This formula is so long, that this makes sense
-	float m0 = body0.mass;
-	float m1 = body1.mass;
-	float l0 = body0.length;
-	float l1 = body1.length;
-	float t0 = body0.theta;
-	float t1 = body1.theta;
-	float w0 = body0.omega;
-	float w1 = body1.omega;
-	float g = GRAVITY;
-
-	return (cosf(t0 - t1) * (m1 * l1 * w1 * w1 * sinf(t0 - t1) + (m0 + m1) * g * sinf(t0))
-		- (m0 + m1) * (l0 * w0 * w0 * sinf(t1 - t0) + g * sinf(t1))) 
-		/ (l1 * (m0 + m1 * sinf(t0 - t1) * sinf(t0-t1)));
-}
- 
-float thetadot1(Body body0, Body body1) {
-	return body1.omega;
-}
-
 Vector2 getPos(Body body) {
 	return Vector2Scale((Vector2){
 		sinf(body.theta), 
@@ -307,25 +532,29 @@ Vector2 getPos(Body body) {
 	}, body.length);
 }
 
-float getEnergy(Body body0, Body body1) {
-	// E = 0.5mv^2 + mgh
-	// This formula is so long, that this makes sense
-	float m0 = body0.mass;
-	float m1 = body1.mass;
-	float l0 = body0.length;
-	float l1 = body1.length;
-	float t0 = body0.theta;
-	float t1 = body1.theta;
-	float w0 = body0.omega;
-	float w1 = body1.omega;
-	float g = GRAVITY;
-
-	float kinetic = 0.5f * (m0 + m1) * l0 * l0 * w0 * w0
-		+ 0.5f * m1 * l1 * l1 * w1 * w1
-		+ m1 * l0 * l1 * w0 * w1 * cosf(t0 - t1);
-	float potential = (m0 + m1) * g * l0 * (1 - cosf(t0))
-		+ m1 * g * l1 * (1 - cosf(t1));
-	return kinetic + potential;
+// Grid of pendulums around body0 and body1, theta0 varying down the rows and
+// theta1 across, colored the same way so nearby starts share a color
+void resetEnsemble(Ensemble *ensemble, EnsembleView *view, Body body0, Body body1, int side, float spread) {
+	Color *colors = malloc(ensemble->count * sizeof(Color));
+	if (colors == NULL) {
+		return;
+	}
+	for (int row = 0; row < side; ++row) {
+		for (int col = 0; col < side; ++col) {
+			float u = (float)row / (side - 1);
+			float v = (float)col / (side - 1);
+			Body b0 = body0;
+			Body b1 = body1;
+			b0.theta += spread * (u - 0.5f);
+			b1.theta += spread * (v - 0.5f);
+			int i = row * side + col;
+			setEnsembleBodies(ensemble, i, b0, b1);
+			ensemble->id[i] = i;
+			colors[i] = Fade(ColorFromHSV(300.0f * u, 1.0f - 0.6f * v, 1.0f), 0.6f);
+		}
+	}
+	setEnsembleViewColors(view, ensemble, colors);
+	free(colors);
 }
 
 void startSim(void *state) {
@@ -343,19 +572,23 @@ void startSim(void *state) {
 			startBtnState->button->borderColor = DARKGREEN;
 			startBtnState->button->text = "Start";
 			break;
+		case REPLAY:
+			break;
 	}
 }
 
-TableRow newTableRow(int posX, int posY) {
+// The sliders start wherever body is, as far as their ranges go
+TableRow newTableRow(int posX, int posY, Body body) {
 	return (TableRow){
 		.posX = posX,
 		.posY = posY,
-		.massSlider = newSlider(0.3f, posX + TABLE_SLIDER_OFFSET, 
-							posY + ROW_HEIGHT / 6, SLIDER_LEN),
-		.lengthSlider = newSlider(0.3f, posX + TABLE_SLIDER_OFFSET,
+		.massSlider = newSlider(Clamp(Normalize(body.mass, MIN_MASS, MAX_MASS), 0.0f, 1.0f),
+							posX + TABLE_SLIDER_OFFSET, posY + ROW_HEIGHT / 6, SLIDER_LEN),
+		.lengthSlider = newSlider(Clamp(Normalize(body.length, MIN_LENGTH, MAX_LENGTH), 0.0f, 1.0f),
+							posX + TABLE_SLIDER_OFFSET,
 							posY + ROW_HEIGHT * 3 / 6,
 							SLIDER_LEN),
-		.thetaSlider = newSlider(0.3f, posX + TABLE_SLIDER_OFFSET,
+		.thetaSlider = newSlider(Wrap(body.theta / (2.0f * PI), 0.0f, 1.0f), posX + TABLE_SLIDER_OFFSET,
 							posY + ROW_HEIGHT * 5 / 6, 
 						    SLIDER_LEN),
 	};
@@ -0,0 +1,211 @@
+#include <math.h>
+#include <stdlib.h>
+#include "include/ensemble.h"
+#include "include/thread.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ENSEMBLE_X86 1
+#else
+#define ENSEMBLE_X86 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <malloc.h>
+#define alignedAlloc(size) _aligned_malloc(size, 64)
+#define alignedFree(ptr) _aligned_free(ptr)
+#else
+#define alignedAlloc(size) aligned_alloc(64, size)
+#define alignedFree(ptr) free(ptr)
+#endif
+
+// Plain C instance of the kernel, used when no vector unit is available
+#define LANES 1
+#define VEC float
+#define IVEC int
+#define VMASK int
+#define VLOAD(p) (*(p))
+#define VSTORE(p, v) (*(p) = (v))
+#define VSET1(x) (x)
+#define VADD(a, b) ((a) + (b))
+#define VSUB(a, b) ((a) - (b))
+#define VMUL(a, b) ((a) * (b))
+#define VDIV(a, b) ((a) / (b))
+#define VFMA(a, b, c) ((a) * (b) + (c))
+#define VROUND(x) nearbyintf(x)
+#define VCVTI(x) ((int)(x))
+#define VBIT(q, bit) (((q) & (bit)) != 0)
+#define VBLEND(m, a, b) ((m) ? (a) : (b))
+#define VLIVE(v) ((v) > 0.0f)
+#define VANY(m) (m)
+#define KERNEL_NAME stepEnsembleScalar
+
+#include "include/ensemble_kernel.h"
+
+typedef void (*EnsembleKernel)(Ensemble *e, int begin, int end, float dt);
+
+#if ENSEMBLE_X86
+void stepEnsembleSse(Ensemble *e, int begin, int end, float dt);
+void stepEnsembleAvx2(Ensemble *e, int begin, int end, float dt);
+void stepEnsembleAvx512(Ensemble *e, int begin, int end, float dt);
+
+#if defined(_MSC_VER)
+static int cpuHas(int leaf, int reg, int bit) {
+	int info[4];
+	__cpuidex(info, leaf, 0);
+	return (info[reg] >> bit) & 1;
+}
+static int osSaves(unsigned long long mask) {
+	return cpuHas(1, 2, 27) && (_xgetbv(0) & mask) == mask; // OSXSAVE
+}
+static int hasSse41(void) { return cpuHas(1, 2, 19); }
+static int hasAvx2(void) { return osSaves(0x6) && cpuHas(7, 1, 5) && cpuHas(1, 2, 12); }
+static int hasAvx512(void) { return osSaves(0xE6) && cpuHas(7, 1, 16); }
+#else
+static int hasSse41(void) { return __builtin_cpu_supports("sse4.1"); }
+static int hasAvx2(void) { return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"); }
+static int hasAvx512(void) { return __builtin_cpu_supports("avx512f"); }
+#endif
+#endif
+
+typedef struct KernelChoice {
+	EnsembleKernel step;
+	const char *name;
+} KernelChoice;
+
+enum { KERNEL_SCALAR, KERNEL_SSE, KERNEL_AVX2, KERNEL_AVX512 };
+
+static const KernelChoice kernels[] = {
+	{stepEnsembleScalar, "Scalar"},
+#if ENSEMBLE_X86
+	{stepEnsembleSse, "SSE4.1"},
+	{stepEnsembleAvx2, "AVX2"},
+	{stepEnsembleAvx512, "AVX-512"},
+#endif
+};
+
+// Index into kernels plus one, 0 until it's been picked. newEnsemble picks
+// it before any pool worker steps one, and it's atomic so a late first
+// call from several threads at once still only ever sees a finished pick.
+static Atomic64 chosenKernel;
+
+static const KernelChoice *getKernel(void) {
+	long long k = atomicLoad(&chosenKernel);
+	if (k == 0) {
+		int pick = KERNEL_SCALAR;
+		#if ENSEMBLE_X86
+		if (hasAvx512()) {
+			pick = KERNEL_AVX512;
+		} else if (hasAvx2()) {
+			pick = KERNEL_AVX2;
+		} else if (hasSse41()) {
+			pick = KERNEL_SSE;
+		}
+		#endif
+		k = pick + 1;
+		atomicStore(&chosenKernel, k);
+	}
+	return &kernels[k - 1];
+}
+
+Ensemble newEnsemble(int count, float g) {
+	Ensemble e = {0};
+	e.count = count;
+	e.capacity = (count + ENSEMBLE_LANES - 1) / ENSEMBLE_LANES * ENSEMBLE_LANES;
+	e.g = g;
+	getKernel();
+
+	float *block = alignedAlloc(9 * (size_t)e.capacity * sizeof(float));
+	e.id = malloc((size_t)e.capacity * sizeof(int));
+	if (block == NULL || e.id == NULL) {
+		alignedFree(block);
+		free(e.id);
+		return (Ensemble){0};
+	}
+	float **fields[] = {&e.theta0, &e.omega0, &e.theta1, &e.omega1,
+		&e.mass0, &e.mass1, &e.length0, &e.length1, &e.active};
+	for (int f = 0; f < 9; ++f) {
+		*fields[f] = block + f * e.capacity;
+	}
+
+	// Padding lanes get harmless values so the vector kernels can run over them
+	for (int i = 0; i < e.capacity; ++i) {
+		setEnsembleBodies(&e, i, (Body){1, 1, 0, 0}, (Body){1, 1, 0, 0});
+		e.active[i] = (i < count) ? 1.0f : 0.0f;
+		e.id[i] = i;
+	}
+	return e;
+}
+
+void freeEnsemble(Ensemble *ensemble) {
+	alignedFree(ensemble->theta0);
+	free(ensemble->id);
+	*ensemble = (Ensemble){0};
+}
+
+void setEnsembleBodies(Ensemble *ensemble, int i, Body body0, Body body1) {
+	ensemble->theta0[i] = body0.theta;
+	ensemble->omega0[i] = body0.omega;
+	ensemble->mass0[i] = body0.mass;
+	ensemble->length0[i] = body0.length;
+	ensemble->theta1[i] = body1.theta;
+	ensemble->omega1[i] = body1.omega;
+	ensemble->mass1[i] = body1.mass;
+	ensemble->length1[i] = body1.length;
+}
+
+void getEnsembleBodies(const Ensemble *ensemble, int i, Body *body0, Body *body1) {
+	*body0 = (Body){ensemble->mass0[i], ensemble->length0[i], ensemble->theta0[i], ensemble->omega0[i]};
+	*body1 = (Body){ensemble->mass1[i], ensemble->length1[i], ensemble->theta1[i], ensemble->omega1[i]};
+}
+
+void setEnsembleActive(Ensemble *ensemble, int i, int active) {
+	ensemble->active[i] = active ? 1.0f : 0.0f;
+}
+
+static void swapLanes(Ensemble *e, int a, int b) {
+	float *fields[] = {e->theta0, e->omega0, e->theta1, e->omega1,
+		e->mass0, e->mass1, e->length0, e->length1, e->active};
+	for (int f = 0; f < 9; ++f) {
+		float tmp = fields[f][a];
+		fields[f][a] = fields[f][b];
+		fields[f][b] = tmp;
+	}
+	int id = e->id[a];
+	e->id[a] = e->id[b];
+	e->id[b] = id;
+}
+
+int compactEnsembleRange(Ensemble *ensemble, int begin, int end) {
+	// Fill holes at the front with active lanes from the back
+	int lo = begin, hi = end - 1;
+	for (;;) {
+		while (lo <= hi && ensemble->active[lo] > 0.0f) {
+			++lo;
+		}
+		while (lo <= hi && ensemble->active[hi] <= 0.0f) {
+			--hi;
+		}
+		if (lo >= hi) {
+			return lo;
+		}
+		swapLanes(ensemble, lo++, hi--);
+	}
+}
+
+void stepEnsemble(Ensemble *ensemble, float dt) {
+	stepEnsembleRange(ensemble, 0, ensemble->count, dt);
+}
+
+void stepEnsembleRange(Ensemble *ensemble, int begin, int end, float dt) {
+	// Round up into the padding so the last vector is always full
+	end = (end + ENSEMBLE_LANES - 1) / ENSEMBLE_LANES * ENSEMBLE_LANES;
+	if (end > ensemble->capacity) {
+		end = ensemble->capacity;
+	}
+	getKernel()->step(ensemble, begin, end, dt);
+}
+
+const char *getEnsembleIsa(void) {
+	return getKernel()->name;
+}
@@ -0,0 +1,29 @@
+// Only built for x86-64, elsewhere ensemble.c uses the scalar kernel
+#if defined(__x86_64__) || defined(_M_X64)
+
+#include <immintrin.h>
+
+#define LANES 8
+#define VEC __m256
+#define IVEC __m256i
+#define VMASK __m256
+#define VLOAD(p) _mm256_loadu_ps(p)
+#define VSTORE(p, v) _mm256_storeu_ps(p, v)
+#define VSET1(x) _mm256_set1_ps(x)
+#define VADD(a, b) _mm256_add_ps(a, b)
+#define VSUB(a, b) _mm256_sub_ps(a, b)
+#define VMUL(a, b) _mm256_mul_ps(a, b)
+#define VDIV(a, b) _mm256_div_ps(a, b)
+#define VFMA(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define VROUND(x) _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define VCVTI(x) _mm256_cvtps_epi32(x)
+#define VBIT(q, bit) _mm256_castsi256_ps(_mm256_cmpeq_epi32( \
+	_mm256_and_si256(q, _mm256_set1_epi32(bit)), _mm256_set1_epi32(bit)))
+#define VBLEND(m, a, b) _mm256_blendv_ps(b, a, m)
+#define VLIVE(v) _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GT_OQ)
+#define VANY(m) _mm256_movemask_ps(m)
+#define KERNEL_NAME stepEnsembleAvx2
+
+#include "include/ensemble_kernel.h"
+
+#endif // x86-64
@@ -0,0 +1,28 @@
+// Only built for x86-64, elsewhere ensemble.c uses the scalar kernel
+#if defined(__x86_64__) || defined(_M_X64)
+
+#include <immintrin.h>
+
+#define LANES 16
+#define VEC __m512
+#define IVEC __m512i
+#define VMASK __mmask16
+#define VLOAD(p) _mm512_loadu_ps(p)
+#define VSTORE(p, v) _mm512_storeu_ps(p, v)
+#define VSET1(x) _mm512_set1_ps(x)
+#define VADD(a, b) _mm512_add_ps(a, b)
+#define VSUB(a, b) _mm512_sub_ps(a, b)
+#define VMUL(a, b) _mm512_mul_ps(a, b)
+#define VDIV(a, b) _mm512_div_ps(a, b)
+#define VFMA(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define VROUND(x) _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define VCVTI(x) _mm512_cvtps_epi32(x)
+#define VBIT(q, bit) _mm512_test_epi32_mask(q, _mm512_set1_epi32(bit))
+#define VBLEND(m, a, b) _mm512_mask_blend_ps(m, b, a)
+#define VLIVE(v) _mm512_cmp_ps_mask(v, _mm512_setzero_ps(), _CMP_GT_OQ)
+#define VANY(m) (m)
+#define KERNEL_NAME stepEnsembleAvx512
+
+#include "include/ensemble_kernel.h"
+
+#endif // x86-64
@@ -0,0 +1,29 @@
+// Only built for x86-64, elsewhere ensemble.c uses the scalar kernel
+#if defined(__x86_64__) || defined(_M_X64)
+
+#include <smmintrin.h>
+
+#define LANES 4
+#define VEC __m128
+#define IVEC __m128i
+#define VMASK __m128
+#define VLOAD(p) _mm_loadu_ps(p)
+#define VSTORE(p, v) _mm_storeu_ps(p, v)
+#define VSET1(x) _mm_set1_ps(x)
+#define VADD(a, b) _mm_add_ps(a, b)
+#define VSUB(a, b) _mm_sub_ps(a, b)
+#define VMUL(a, b) _mm_mul_ps(a, b)
+#define VDIV(a, b) _mm_div_ps(a, b)
+#define VFMA(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define VROUND(x) _mm_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define VCVTI(x) _mm_cvtps_epi32(x)
+#define VBIT(q, bit) _mm_castsi128_ps(_mm_cmpeq_epi32( \
+	_mm_and_si128(q, _mm_set1_epi32(bit)), _mm_set1_epi32(bit)))
+#define VBLEND(m, a, b) _mm_blendv_ps(b, a, m)
+#define VLIVE(v) _mm_cmpgt_ps(v, _mm_setzero_ps())
+#define VANY(m) _mm_movemask_ps(m)
+#define KERNEL_NAME stepEnsembleSse
+
+#include "include/ensemble_kernel.h"
+
+#endif // x86-64
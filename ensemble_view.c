@@ -0,0 +1,129 @@
+#include <math.h>
+#include <stddef.h>
+#include "include/ensemble_view.h"
+#include "include/raymath.h"
+
+#define QUAD_VERTICES 4
+#define PENDULUM_VERTICES (4 * QUAD_VERTICES) // two arms, two bobs
+#define PENDULUM_INDICES (4 * 6)
+#define VIEW_DEPTH -0.5f // inside the depth range of raylib's 2D projection
+
+static int getChunkCount(const EnsembleView *view, int mesh) {
+	int left = view->count - mesh * ENSEMBLE_VIEW_CHUNK;
+	return left < ENSEMBLE_VIEW_CHUNK ? left : ENSEMBLE_VIEW_CHUNK;
+}
+
+// Quad of half width w along p -> q. The corners always go round the same
+// way, so the triangles face the camera whichever way the arm points.
+static float *writeQuad(float *v, Vector2 p, Vector2 q, float w) {
+	Vector2 d = Vector2Subtract(q, p);
+	float len = Vector2Length(d);
+	Vector2 n = (len > 0.0f) ? (Vector2){-d.y * w / len, d.x * w / len} : (Vector2){0.0f, w};
+	Vector2 corners[QUAD_VERTICES] = {
+		Vector2Add(p, n), Vector2Subtract(p, n), Vector2Subtract(q, n), Vector2Add(q, n)
+	};
+	for (int k = 0; k < QUAD_VERTICES; ++k) {
+		*v++ = corners[k].x;
+		*v++ = corners[k].y;
+		*v++ = VIEW_DEPTH;
+	}
+	return v;
+}
+
+EnsembleView newEnsembleView(int count) {
+	EnsembleView view = {0};
+	view.count = count;
+	view.meshCount = (count + ENSEMBLE_VIEW_CHUNK - 1) / ENSEMBLE_VIEW_CHUNK;
+	view.meshes = MemAlloc(view.meshCount * sizeof(Mesh));
+	if (view.meshes == NULL) {
+		return view;
+	}
+	for (int m = 0; m < view.meshCount; ++m) {
+		int n = getChunkCount(&view, m);
+		Mesh *mesh = &view.meshes[m];
+		mesh->vertexCount = n * PENDULUM_VERTICES;
+		mesh->triangleCount = n * PENDULUM_INDICES / 3;
+		mesh->vertices = MemAlloc(mesh->vertexCount * 3 * sizeof(float));
+		mesh->colors = MemAlloc(mesh->vertexCount * 4);
+		mesh->indices = MemAlloc(n * PENDULUM_INDICES * sizeof(unsigned short));
+		if (mesh->vertices == NULL || mesh->colors == NULL || mesh->indices == NULL) {
+			MemFree(mesh->vertices);
+			MemFree(mesh->colors);
+			MemFree(mesh->indices);
+			for (int k = 0; k < m; ++k) {
+				UnloadMesh(view.meshes[k]);
+			}
+			MemFree(view.meshes);
+			view.meshes = NULL;
+			return view;
+		}
+		// Quad a b c d is drawn as a c b and a d c, see writeQuad
+		unsigned short *index = mesh->indices;
+		for (int q = 0; q < n * PENDULUM_VERTICES / QUAD_VERTICES; ++q) {
+			unsigned short a = (unsigned short)(q * QUAD_VERTICES);
+			*index++ = a;
+			*index++ = a + 2;
+			*index++ = a + 1;
+			*index++ = a;
+			*index++ = a + 3;
+			*index++ = a + 2;
+		}
+		UploadMesh(mesh, true);
+	}
+	view.material = LoadMaterialDefault();
+	return view;
+}
+
+void freeEnsembleView(EnsembleView *view) {
+	if (view->meshes == NULL) {
+		return;
+	}
+	for (int m = 0; m < view->meshCount; ++m) {
+		// UnloadMesh frees the CPU copies too
+		UnloadMesh(view->meshes[m]);
+	}
+	MemFree(view->meshes);
+	view->meshes = NULL;
+	UnloadMaterial(view->material);
+}
+
+void setEnsembleViewColors(EnsembleView *view, const Ensemble *ensemble, const Color colors[]) {
+	for (int m = 0; m < view->meshCount; ++m) {
+		Mesh *mesh = &view->meshes[m];
+		int n = getChunkCount(view, m);
+		for (int j = 0; j < n; ++j) {
+			Color color = colors[ensemble->id[m * ENSEMBLE_VIEW_CHUNK + j]];
+			unsigned char *c = mesh->colors + j * PENDULUM_VERTICES * 4;
+			for (int k = 0; k < PENDULUM_VERTICES; ++k) {
+				*c++ = color.r;
+				*c++ = color.g;
+				*c++ = color.b;
+				*c++ = color.a;
+			}
+		}
+		UpdateMeshBuffer(*mesh, 3, mesh->colors, mesh->vertexCount * 4, 0);
+	}
+}
+
+void drawEnsembleView(EnsembleView *view, const Ensemble *ensemble, Vector2 origin) {
+	for (int m = 0; m < view->meshCount; ++m) {
+		Mesh *mesh = &view->meshes[m];
+		int first = m * ENSEMBLE_VIEW_CHUNK;
+		int n = getChunkCount(view, m);
+		float *v = mesh->vertices;
+		for (int j = first; j < first + n; ++j) {
+			Vector2 pos0 = {origin.x + ensemble->length0[j] * sinf(ensemble->theta0[j]),
+							origin.y + ensemble->length0[j] * cosf(ensemble->theta0[j])};
+			Vector2 pos1 = {pos0.x + ensemble->length1[j] * sinf(ensemble->theta1[j]),
+							pos0.y + ensemble->length1[j] * cosf(ensemble->theta1[j])};
+			v = writeQuad(v, origin, pos0, ENSEMBLE_VIEW_ARM);
+			v = writeQuad(v, pos0, pos1, ENSEMBLE_VIEW_ARM);
+			v = writeQuad(v, (Vector2){pos0.x - ENSEMBLE_VIEW_BOB, pos0.y},
+						  (Vector2){pos0.x + ENSEMBLE_VIEW_BOB, pos0.y}, ENSEMBLE_VIEW_BOB);
+			v = writeQuad(v, (Vector2){pos1.x - ENSEMBLE_VIEW_BOB, pos1.y},
+						  (Vector2){pos1.x + ENSEMBLE_VIEW_BOB, pos1.y}, ENSEMBLE_VIEW_BOB);
+		}
+		UpdateMeshBuffer(*mesh, 0, mesh->vertices, mesh->vertexCount * 3 * sizeof(float), 0);
+		DrawMesh(*mesh, view->material, MatrixIdentity());
+	}
+}
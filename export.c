@@ -0,0 +1,338 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/export.h"
+#include "include/jobs.h"
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#define popen _popen
+#define pclose _pclose
+#define PIPE_MODE "wb"
+#else
+#include <signal.h>
+#define PIPE_MODE "w"
+#endif
+
+#define PATH_MAX_LEN 1024
+
+// Same colors as the viewers
+typedef struct Rgb {
+	unsigned char r, g, b;
+} Rgb;
+
+static const Rgb BACKGROUND = {0, 0, 0};
+static const Rgb ARM = {255, 255, 255};
+static const Rgb PIVOT = {230, 41, 55};
+static const Rgb BOB = {0, 121, 241};
+static const Rgb TRAIL = {102, 191, 255};
+
+typedef struct Raster {
+	int width;
+	int height;
+	unsigned char *rgb;
+} Raster;
+
+typedef struct ExportBatch {
+	const ExportOptions *options;
+	Raster rasters[EXPORT_BATCH_FRAMES];
+	Body *states; // [EXPORT_BATCH_FRAMES][count], what each frame shows
+	long long trailEnd[EXPORT_BATCH_FRAMES]; // trail points pushed before each frame
+	long long firstFrame;
+
+	// Last bob after every physics step, in pixels
+	float *trailX;
+	float *trailY;
+	int trailCapacity;
+
+	Atomic64 failed;
+} ExportBatch;
+
+static void blendPixel(Raster *raster, int x, int y, Rgb color, float alpha) {
+	if (x < 0 || y < 0 || x >= raster->width || y >= raster->height || alpha <= 0.0f) {
+		return;
+	}
+	unsigned char *p = raster->rgb + 3 * ((size_t)y * raster->width + x);
+	if (alpha >= 1.0f) {
+		p[0] = color.r;
+		p[1] = color.g;
+		p[2] = color.b;
+		return;
+	}
+	p[0] = (unsigned char)(p[0] + alpha * (color.r - p[0]));
+	p[1] = (unsigned char)(p[1] + alpha * (color.g - p[1]));
+	p[2] = (unsigned char)(p[2] + alpha * (color.b - p[2]));
+}
+
+// One pixel wide and antialiased, each step along the long axis splits its
+// coverage between the two nearest pixels across it
+static void drawLine(Raster *raster, float x0, float y0, float x1, float y1, Rgb color, float alpha) {
+	float dx = x1 - x0;
+	float dy = y1 - y0;
+	int steep = fabsf(dy) > fabsf(dx);
+	if (steep) {
+		float t = x0; x0 = y0; y0 = t;
+		t = x1; x1 = y1; y1 = t;
+		t = dx; dx = dy; dy = t;
+	}
+	if (x1 < x0) {
+		float t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+	float slope = (dx != 0.0f) ? dy / dx : 0.0f;
+	for (int x = (int)floorf(x0 + 0.5f); x <= (int)floorf(x1 + 0.5f); ++x) {
+		float y = y0 + slope * (x - x0);
+		int yi = (int)floorf(y);
+		float f = y - yi;
+		if (steep) {
+			blendPixel(raster, yi, x, color, alpha * (1.0f - f));
+			blendPixel(raster, yi + 1, x, color, alpha * f);
+		} else {
+			blendPixel(raster, x, yi, color, alpha * (1.0f - f));
+			blendPixel(raster, x, yi + 1, color, alpha * f);
+		}
+	}
+}
+
+static void fillCircle(Raster *raster, float cx, float cy, float radius, Rgb color) {
+	int x0 = (int)floorf(cx - radius - 1), x1 = (int)ceilf(cx + radius + 1);
+	int y0 = (int)floorf(cy - radius - 1), y1 = (int)ceilf(cy + radius + 1);
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			float d = hypotf(x + 0.5f - cx, y + 0.5f - cy);
+			float coverage = radius + 0.5f - d;
+			blendPixel(raster, x, y, color, coverage > 1.0f ? 1.0f : coverage);
+		}
+	}
+}
+
+static void renderFrame(void *ctx, int k, int worker) {
+	(void)worker;
+	ExportBatch *batch = (ExportBatch *)ctx;
+	const ExportOptions *o = batch->options;
+	Raster *raster = &batch->rasters[k];
+	const Body *bodies = batch->states + (size_t)k * o->count;
+
+	for (size_t p = 0; p < (size_t)raster->width * raster->height; ++p) {
+		raster->rgb[3 * p] = BACKGROUND.r;
+		raster->rgb[3 * p + 1] = BACKGROUND.g;
+		raster->rgb[3 * p + 2] = BACKGROUND.b;
+	}
+
+	float x[EXPORT_MAX_BODIES + 1], y[EXPORT_MAX_BODIES + 1];
+	x[0] = o->originX;
+	y[0] = o->originY;
+	for (int i = 0; i < o->count; ++i) {
+		x[i + 1] = x[i] + o->scale * (float)bodies[i].length * sinf((float)bodies[i].theta);
+		y[i + 1] = y[i] + o->scale * (float)bodies[i].length * cosf((float)bodies[i].theta);
+	}
+
+	// Fading from the oldest point in, ending at where the bob is drawn
+	long long end = batch->trailEnd[k];
+	long long begin = end - o->trail > 0 ? end - o->trail : 0;
+	for (long long p = begin; p < end; ++p) {
+		int a = (int)(p % batch->trailCapacity);
+		float toX = x[o->count], toY = y[o->count];
+		if (p + 1 < end) {
+			int b = (int)((p + 1) % batch->trailCapacity);
+			toX = batch->trailX[b];
+			toY = batch->trailY[b];
+		}
+		float alpha = (float)(p - begin + 1) / (end - begin);
+		drawLine(raster, batch->trailX[a], batch->trailY[a], toX, toY, TRAIL, alpha);
+	}
+
+	for (int i = 0; i < o->count; ++i) {
+		drawLine(raster, x[i], y[i], x[i + 1], y[i + 1], ARM, 1.0f);
+	}
+	fillCircle(raster, x[0], y[0], o->scale * o->pivotRadius, PIVOT);
+	for (int i = 0; i < o->count; ++i) {
+		fillCircle(raster, x[i + 1], y[i + 1], o->scale * o->radius[i], BOB);
+	}
+
+	if (o->format == EXPORT_PPM) {
+		char path[PATH_MAX_LEN];
+		snprintf(path, sizeof(path), o->path, (int)(batch->firstFrame + k));
+		FILE *file = fopen(path, "wb");
+		if (file == NULL) {
+			atomicStore(&batch->failed, 1);
+			return;
+		}
+		fprintf(file, "P6\n%d %d\n255\n", raster->width, raster->height);
+		fwrite(raster->rgb, 3, (size_t)raster->width * raster->height, file);
+		if (fclose(file) != 0) {
+			atomicStore(&batch->failed, 1);
+		}
+	}
+}
+
+static void pushTrail(ExportBatch *batch, long long *count, const Body bodies[]) {
+	const ExportOptions *o = batch->options;
+	float x = o->originX, y = o->originY;
+	for (int i = 0; i < o->count; ++i) {
+		x += o->scale * (float)bodies[i].length * sinf((float)bodies[i].theta);
+		y += o->scale * (float)bodies[i].length * cosf((float)bodies[i].theta);
+	}
+	int slot = (int)(*count % batch->trailCapacity);
+	batch->trailX[slot] = x;
+	batch->trailY[slot] = y;
+	(*count)++;
+}
+
+int parseExportArgs(int argc, char **argv, ExportOptions *options) {
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 >= argc) {
+			fprintf(stderr, "%s needs a value\n", argv[i]);
+			return -1;
+		}
+		const char *value = argv[i + 1];
+		if (strcmp(argv[i], "-export") == 0) {
+			options->format = EXPORT_PPM;
+			options->path = value;
+		} else if (strcmp(argv[i], "-raw") == 0) {
+			options->format = EXPORT_RAW;
+			options->path = value;
+		} else if (strcmp(argv[i], "-pipe") == 0) {
+			options->format = EXPORT_PIPE;
+			options->path = value;
+		} else if (strcmp(argv[i], "-t") == 0) {
+			options->duration = (float)atof(value);
+		} else if (strcmp(argv[i], "-fps") == 0) {
+			options->fps = atoi(value);
+		} else if (strcmp(argv[i], "-w") == 0) {
+			options->width = atoi(value);
+		} else if (strcmp(argv[i], "-h") == 0) {
+			options->height = atoi(value);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			options->threads = atoi(value);
+		} else if (strcmp(argv[i], "-trail") == 0) {
+			options->trail = atoi(value);
+		} else {
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return -1;
+		}
+	}
+	return options->format != EXPORT_NONE;
+}
+
+long long runExport(const ExportOptions *o) {
+	if (o->format == EXPORT_NONE || o->path == NULL || o->width <= 0 || o->height <= 0 ||
+		o->fps <= 0 || o->dt <= 0.0f || o->count < 1 || o->count > EXPORT_MAX_BODIES) {
+		return -1;
+	}
+
+	ExportBatch batch = {.options = o};
+	int stepsPerFrame = (int)ceil(1.0 / (o->fps * (double)o->dt)) + 1;
+	batch.trailCapacity = o->trail + EXPORT_BATCH_FRAMES * stepsPerFrame + 1;
+	batch.trailX = malloc(batch.trailCapacity * sizeof(float));
+	batch.trailY = malloc(batch.trailCapacity * sizeof(float));
+	batch.states = malloc((size_t)EXPORT_BATCH_FRAMES * o->count * sizeof(Body));
+	Body *prev = malloc(o->count * sizeof(Body));
+	Body *curr = malloc(o->count * sizeof(Body));
+	int ok = batch.trailX != NULL && batch.trailY != NULL && batch.states != NULL &&
+			 prev != NULL && curr != NULL;
+	for (int k = 0; k < EXPORT_BATCH_FRAMES; ++k) {
+		batch.rasters[k] = (Raster){o->width, o->height, malloc((size_t)o->width * o->height * 3)};
+		ok = ok && batch.rasters[k].rgb != NULL;
+	}
+	JobPool *pool = ok ? newJobPool(o->threads) : NULL;
+
+	FILE *stream = NULL;
+#if !defined(_WIN32)
+	struct sigaction savedPipe;
+#endif
+	if (pool != NULL && o->format == EXPORT_RAW && strcmp(o->path, "-") == 0) {
+#if defined(_WIN32)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		stream = stdout;
+	} else if (pool != NULL && o->format == EXPORT_RAW) {
+		stream = fopen(o->path, "wb");
+	} else if (pool != NULL && o->format == EXPORT_PIPE) {
+#if !defined(_WIN32)
+		// An encoder that quits early would otherwise kill us on the next
+		// write, this way the write just fails and it's reported
+		struct sigaction ignore = {.sa_handler = SIG_IGN};
+		sigemptyset(&ignore.sa_mask);
+		sigaction(SIGPIPE, &ignore, &savedPipe);
+#endif
+		stream = popen(o->path, PIPE_MODE);
+	}
+
+	long long written = -1;
+	if (pool != NULL && (o->format == EXPORT_PPM || stream != NULL)) {
+		long long frames = (long long)floor((double)o->duration * o->fps) + 1;
+		long long trailCount = 0;
+		double simTime = 0.0;
+		memcpy(curr, o->bodies, o->count * sizeof(Body));
+		memcpy(prev, curr, o->count * sizeof(Body));
+		pushTrail(&batch, &trailCount, curr);
+
+		written = 0;
+		for (long long first = 0; first < frames && !atomicLoad(&batch.failed); first += EXPORT_BATCH_FRAMES) {
+			int n = (frames - first < EXPORT_BATCH_FRAMES) ? (int)(frames - first) : EXPORT_BATCH_FRAMES;
+			for (int k = 0; k < n; ++k) {
+				// Step past the frame's time, then go back between the last two states
+				double t = (double)(first + k) / o->fps;
+				while (simTime < t - 1e-3 * o->dt) {
+					memcpy(prev, curr, o->count * sizeof(Body));
+					solveSystem(curr, o->count, o->g, o->dt, o->integrator);
+					simTime += o->dt;
+					pushTrail(&batch, &trailCount, curr);
+				}
+				real alpha = (real)(1.0 - (simTime - t) / o->dt);
+				Body *state = batch.states + (size_t)k * o->count;
+				for (int i = 0; i < o->count; ++i) {
+					state[i] = interpolateBody(prev[i], curr[i], alpha > 1 ? 1 : alpha);
+				}
+				batch.trailEnd[k] = trailCount;
+			}
+			batch.firstFrame = first;
+			runJobs(pool, n, renderFrame, &batch);
+
+			for (int k = 0; k < n && stream != NULL; ++k) {
+				size_t pixels = (size_t)o->width * o->height;
+				if (fwrite(batch.rasters[k].rgb, 3, pixels, stream) != pixels) {
+					atomicStore(&batch.failed, 1);
+					break;
+				}
+			}
+			written += n;
+		}
+		if (atomicLoad(&batch.failed)) {
+			written = -1;
+		}
+	}
+
+	if (stream == stdout) {
+		fflush(stdout);
+	} else if (stream != NULL && o->format == EXPORT_PIPE) {
+		// The command's exit status, an encoder that choked on the stream
+		// didn't produce the video
+		if (pclose(stream) != 0) {
+			written = -1;
+		}
+	} else if (stream != NULL && fclose(stream) != 0) {
+		written = -1;
+	}
+#if !defined(_WIN32)
+	if (pool != NULL && o->format == EXPORT_PIPE) {
+		sigaction(SIGPIPE, &savedPipe, NULL);
+	}
+#endif
+	freeJobPool(pool);
+	for (int k = 0; k < EXPORT_BATCH_FRAMES; ++k) {
+		free(batch.rasters[k].rgb);
+	}
+	free(batch.trailX);
+	free(batch.trailY);
+	free(batch.states);
+	free(prev);
+	free(curr);
+	return written;
+}
@@ -0,0 +1,29 @@
+#include "include/fixedstep.h"
+
+FixedStep newFixedStep(float dt, int maxSteps) {
+	return (FixedStep){dt, 0.0f, maxSteps};
+}
+
+int advanceFixedStep(FixedStep *clock, float frameTime, float speedup) {
+	if (frameTime > MAX_FRAME_TIME) {
+		frameTime = MAX_FRAME_TIME;
+	}
+	clock->accumulator += frameTime * speedup;
+
+	int steps = (int)(clock->accumulator / clock->dt);
+	if (steps > clock->maxSteps) {
+		// Can't keep up, so let the simulation fall behind instead of spiralling
+		steps = clock->maxSteps;
+		clock->accumulator = clock->dt * steps;
+	}
+	clock->accumulator -= clock->dt * steps;
+	if (clock->accumulator < 0.0f) {
+		clock->accumulator = 0.0f;
+	}
+	return steps;
+}
+
+float getFixedStepAlpha(FixedStep clock) {
+	float alpha = clock.accumulator / clock.dt;
+	return alpha > 1.0f ? 1.0f : alpha;
+}
@@ -0,0 +1,147 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/flipmap.h"
+#include "include/trace.h"
+
+// Headless flip-time map, see flipmap.h. Writes a binary PPM.
+//
+//   flip_map [-w width] [-h height] [-t seconds] [-dt step] [-j threads] [-o out.ppm]
+//            [-trace trace.json]
+
+#define GRAVITY 9.81f
+#define WIDTH 1024
+#define HEIGHT 1024
+#define MAX_TIME 100.0f
+#define PHYSICS_DT 0.01f
+#define OUTPUT_PATH "flip_map.ppm"
+
+// Quick flips are bright, slow ones fade out to dark blue. Log scale, since
+// the interesting detail is spread over several orders of magnitude.
+static void getFlipColor(const FlipMap *map, float t, unsigned char rgb[3]) {
+	static const float stops[][3] = {
+		{255, 240, 160}, {240, 120, 40}, {170, 30, 80}, {60, 20, 110}, {10, 10, 40},
+	};
+	int last = sizeof(stops) / sizeof(stops[0]) - 1;
+	if (t == FLIP_FORBIDDEN) {
+		rgb[0] = rgb[1] = rgb[2] = 0;
+		return;
+	}
+	if (t == FLIP_TIMEOUT) {
+		rgb[0] = rgb[1] = rgb[2] = 255;
+		return;
+	}
+	float u = logf(t / map->dt) / logf(map->maxTime / map->dt);
+	u = fminf(fmaxf(u, 0.0f), 1.0f) * last;
+	int i = (int)u;
+	if (i >= last) {
+		i = last - 1;
+	}
+	float f = u - i;
+	for (int c = 0; c < 3; ++c) {
+		rgb[c] = (unsigned char)(stops[i][c] + f * (stops[i + 1][c] - stops[i][c]));
+	}
+}
+
+static int writePpm(const char *path, const FlipMap *map) {
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		return 0;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", map->width, map->height);
+	unsigned char *row = malloc(3 * (size_t)map->width);
+	for (int y = 0; row != NULL && y < map->height; ++y) {
+		for (int x = 0; x < map->width; ++x) {
+			getFlipColor(map, map->time[y * map->width + x], row + 3 * x);
+		}
+		fwrite(row, 3, (size_t)map->width, file);
+	}
+	free(row);
+	return fclose(file) == 0 && row != NULL;
+}
+
+int main(int argc, char **argv) {
+	FlipMap map = {
+		.width = WIDTH,
+		.height = HEIGHT,
+		.body0 = (Body){1, 1, 0, 0},
+		.body1 = (Body){1, 1, 0, 0},
+		.g = GRAVITY,
+		.dt = PHYSICS_DT,
+		.maxTime = MAX_TIME,
+	};
+	int threads = 0;
+	const char *output = OUTPUT_PATH;
+	const char *tracePath = NULL;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-w") == 0) {
+			map.width = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "-h") == 0) {
+			map.height = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "-t") == 0) {
+			map.maxTime = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-dt") == 0) {
+			map.dt = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			threads = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "-o") == 0) {
+			output = argv[i + 1];
+		} else if (strcmp(argv[i], "-trace") == 0) {
+			tracePath = argv[i + 1];
+		} else {
+			break;
+		}
+	}
+	if (map.width <= 0 || map.height <= 0 || map.dt <= 0 || map.maxTime < map.dt) {
+		fprintf(stderr, "usage: flip_map [-w width] [-h height] [-t seconds] [-dt step] [-j threads] [-o out.ppm] [-trace trace.json]\n");
+		return 1;
+	}
+
+	map.time = malloc((size_t)map.width * map.height * sizeof(float));
+	JobPool *pool = newJobPool(threads);
+	if (map.time == NULL || pool == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	printf("%dx%d, %g s at dt %g on %d threads (%s)\n", map.width, map.height,
+		map.maxTime, map.dt, getJobPoolSize(pool), getEnsembleIsa());
+	if (tracePath != NULL) {
+		setTraceThreadName("main");
+		startTrace();
+	}
+	double start = getClock();
+	if (!computeFlipMap(pool, &map)) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	double elapsed = getClock() - start;
+	if (tracePath != NULL) {
+		long long events = stopTrace(tracePath);
+		if (events < 0) {
+			fprintf(stderr, "couldn't write %s\n", tracePath);
+		} else {
+			printf("traced %lld events to %s, %lld dropped\n", events, tracePath, getTraceDropped());
+		}
+	}
+
+	long long flipped = 0, forbidden = 0;
+	for (long long p = 0; p < (long long)map.width * map.height; ++p) {
+		flipped += map.time[p] >= 0;
+		forbidden += map.time[p] == FLIP_FORBIDDEN;
+	}
+	printf("%.2f s, %lld flipped, %lld can't flip, %lld still going\n", elapsed, flipped, forbidden,
+		(long long)map.width * map.height - flipped - forbidden);
+
+	if (!writePpm(output, &map)) {
+		fprintf(stderr, "couldn't write %s\n", output);
+		return 1;
+	}
+	printf("wrote %s\n", output);
+
+	freeJobPool(pool);
+	free(map.time);
+	return 0;
+}
@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include "include/flipmap.h"
+#include "include/runner.h"
+
+#define PI 3.14159265358979323846
+
+typedef struct FlipJob {
+	FlipMap *map;
+	Ensemble *scratch; // one per worker
+} FlipJob;
+
+void getFlipMapAngles(const FlipMap *map, int x, int y, real *theta0, real *theta1) {
+	// Pixel centers, so the map is symmetric about the origin
+	*theta0 = (real)(-PI + 2 * PI * (x + 0.5) / map->width);
+	*theta1 = (real)(PI - 2 * PI * (y + 0.5) / map->height);
+}
+
+int canFlip(Body body0, Body body1, float g) {
+	// Starting from rest all the energy is potential. The cheapest way to get
+	// the top arm over is with the bottom one hanging straight down, and the
+	// bottom arm only needs to get itself over.
+	real energy = getDoubleEnergy(body0, body1, g);
+	real top = 2 * (body0.mass + body1.mass) * g * body0.length;
+	real bottom = 2 * body1.mass * g * body1.length;
+	return energy >= ((top < bottom) ? top : bottom);
+}
+
+static int hasFlipped(void *ctx, const Ensemble *e, int i) {
+	return e->theta0[i] > PI || e->theta0[i] < -PI || e->theta1[i] > PI || e->theta1[i] < -PI;
+}
+
+static void flipChunk(void *ctx, int chunk, int worker) {
+	FlipJob *job = (FlipJob *)ctx;
+	FlipMap *map = job->map;
+	Ensemble *e = &job->scratch[worker];
+	int pixels = map->width * map->height;
+	int begin = chunk * FLIPMAP_CHUNK;
+	int end = begin + FLIPMAP_CHUNK;
+	if (end > pixels) {
+		end = pixels;
+	}
+
+	// Only pendulums that can flip go into the ensemble, packed from lane 0
+	int pixel[FLIPMAP_CHUNK];
+	int stopStep[FLIPMAP_CHUNK];
+	int live = 0;
+	for (int p = begin; p < end; ++p) {
+		Body body0 = map->body0, body1 = map->body1;
+		getFlipMapAngles(map, p % map->width, p / map->width, &body0.theta, &body1.theta);
+		body0.omega = body1.omega = 0;
+		if (!canFlip(body0, body1, map->g)) {
+			map->time[p] = FLIP_FORBIDDEN;
+			continue;
+		}
+		setEnsembleBodies(e, live, body0, body1);
+		pixel[live++] = p;
+	}
+	// The last chunk left the lanes shuffled, so every lane is reset
+	for (int i = 0; i < e->capacity; ++i) {
+		if (i >= live) {
+			setEnsembleBodies(e, i, (Body){1, 1, 0, 0}, (Body){1, 1, 0, 0});
+		}
+		setEnsembleActive(e, i, i < live);
+		e->id[i] = i;
+	}
+
+	int steps = (int)(map->maxTime / map->dt);
+	runEnsembleRangeUntil(e, 0, live, map->dt, steps, hasFlipped, NULL, stopStep);
+	for (int i = 0; i < live; ++i) {
+		map->time[pixel[i]] = (stopStep[i] > 0) ? stopStep[i] * map->dt : FLIP_TIMEOUT;
+	}
+}
+
+int computeFlipMap(JobPool *pool, FlipMap *map) {
+	int workers = getJobPoolSize(pool);
+	Ensemble *scratch = calloc((size_t)workers, sizeof(Ensemble));
+	if (scratch == NULL) {
+		return 0;
+	}
+	int ok = 1;
+	for (int w = 0; w < workers; ++w) {
+		scratch[w] = newEnsemble(FLIPMAP_CHUNK, map->g);
+		ok = ok && scratch[w].capacity > 0;
+	}
+
+	if (ok) {
+		FlipJob job = {.map = map, .scratch = scratch};
+		int pixels = map->width * map->height;
+		runJobs(pool, (pixels + FLIPMAP_CHUNK - 1) / FLIPMAP_CHUNK, flipChunk, &job);
+	}
+
+	for (int w = 0; w < workers; ++w) {
+		freeEnsemble(&scratch[w]);
+	}
+	free(scratch);
+	return ok;
+}
@@ -0,0 +1,80 @@
+#ifndef DOPRI_H
+#define DOPRI_H
+
+// Adaptive Dormand-Prince 5(4) integrator. Each step estimates its own error
+// from the embedded 4th order solution and grows or shrinks the step to stay
+// within the tolerance. The last stage of an accepted step is the first stage
+// of the next one (FSAL), so an accepted step costs 6 derivative evaluations.
+// The last step also keeps enough to interpolate anywhere inside it with 4th
+// order accuracy, which is what the renderer uses.
+
+#include "real.h"
+
+#define DOPRI_MAX_DIM 32
+// A step gives up after this many rejections in a row, or once the step size
+// is down to DOPRI_MIN_STEP rounding errors of t
+#define DOPRI_MAX_REJECTS 64
+#define DOPRI_MIN_STEP 16
+
+// dy/dt = f(y), params is whatever the system needs (masses, lengths, ...)
+typedef void (*Derivative)(const real y[], real dydt[], const void *params);
+
+typedef struct Dopri {
+	Derivative f;
+	const void *params;
+	int dim;
+	real tol; // used as both the absolute and relative tolerance
+	real hMax; // largest step allowed, 0 for no limit
+
+	real t;
+	real h; // next step size to try
+	real y[DOPRI_MAX_DIM];
+	real k1[DOPRI_MAX_DIM]; // f(y), carried over from the last step
+
+	// Dense output for the last accepted step [tPrev, t]
+	real tPrev;
+	real hPrev;
+	real dense[5][DOPRI_MAX_DIM];
+
+	int evals; // derivative evaluations so far
+	int accepted;
+	int rejected;
+} Dopri;
+
+void initDopri(Dopri *rk, Derivative f, const void *params, const real y0[], int dim,
+			  real tol, real h);
+// Takes one accepted step, retrying with smaller steps as needed. Returns 0
+// if no step size would do (the state has gone non-finite, or the error
+// won't come down), leaving rk at its last accepted step.
+int stepDopri(Dopri *rk);
+// Steps until rk->t >= tEnd, the state at tEnd can then be read with
+// denseDopri. Returns 0 if a step gave up before getting there.
+int advanceDopri(Dopri *rk, real tEnd);
+// Interpolates the state at time t, which should be inside the last step
+void denseDopri(const Dopri *rk, real t, real y[]);
+
+// Event location on the dense output. An event is a function of the state
+// whose zero crossings are wanted (theta0 = 0 for a Poincare section, say).
+// After every step its sign at both ends is compared, and a crossing is
+// pinned down inside the step by root finding on the interpolant, so it's as
+// exact as the integrator rather than off by up to a whole step.
+
+#define EVENT_MAX_ITER 64
+
+typedef real (*EventFn)(const real y[], const void *ctx);
+
+typedef struct DopriEvent {
+	EventFn fn;
+	const void *ctx;
+	int direction; // 1 only rising crossings, -1 only falling ones, 0 both
+	real last; // fn at the start of the next step
+} DopriEvent;
+
+// Call again whenever the Dopri gets reset
+void initDopriEvent(DopriEvent *event, EventFn fn, const void *ctx, int direction, const Dopri *rk);
+// Checks the step rk just took. Returns 1 and fills t and y if the event
+// crossed zero in it; only the first crossing in a step is found, so the
+// steps should be short next to the time between crossings.
+int locateDopriEvent(DopriEvent *event, const Dopri *rk, real *t, real y[]);
+
+#endif // !DOPRI_H
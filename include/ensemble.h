@@ -0,0 +1,54 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include "pendulum.h"
+
+// A batch of independent double pendulums stored as one array per field, so
+// the RK4 step can run over 4, 8 or 16 of them at a time with SSE, AVX2 or
+// AVX-512. The widest one the CPU supports is picked the first time a step
+// runs, with a plain C version as the fallback. The lanes are always float,
+// whatever precision real is, so bodies are rounded on the way in.
+
+#define ENSEMBLE_LANES 16 // arrays are padded to a multiple of this
+
+typedef struct Ensemble {
+	int count;
+	int capacity; // count rounded up to ENSEMBLE_LANES
+	float g;
+	float *theta0;
+	float *omega0;
+	float *theta1;
+	float *omega1;
+	float *mass0;
+	float *mass1;
+	float *length0;
+	float *length1;
+	float *active; // 1 while a lane is being stepped, 0 once it's switched off
+	int *id; // which pendulum is in each lane, compaction moves them around
+} Ensemble;
+
+Ensemble newEnsemble(int count, float g);
+void freeEnsemble(Ensemble *ensemble);
+void setEnsembleBodies(Ensemble *ensemble, int i, Body body0, Body body1);
+void getEnsembleBodies(const Ensemble *ensemble, int i, Body *body0, Body *body1);
+
+// One RK4 step of dt for every pendulum
+void stepEnsemble(Ensemble *ensemble, float dt);
+// Same, for pendulums [begin, end). begin should be a multiple of ENSEMBLE_LANES
+void stepEnsembleRange(Ensemble *ensemble, int begin, int end, float dt);
+
+// Early exit for runs that stop each pendulum on some event (a flip, an
+// energy threshold, ...). Switched off lanes keep their state and vectors
+// with no active lanes are skipped, and compacting moves the active lanes to
+// the front so the steps only run over full vectors. Lanes start active,
+// the padding starts switched off.
+void setEnsembleActive(Ensemble *ensemble, int i, int active);
+// Reorders lanes [begin, end) so the active ones come first and returns where
+// they end. Lanes are swapped whole, id included. begin should be a multiple
+// of ENSEMBLE_LANES.
+int compactEnsembleRange(Ensemble *ensemble, int begin, int end);
+
+// Which kernel stepEnsemble uses, "AVX-512", "AVX2", "SSE4.1" or "Scalar"
+const char *getEnsembleIsa(void);
+
+#endif // !ENSEMBLE_H
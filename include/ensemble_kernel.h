@@ -0,0 +1,116 @@
+// RK4 kernel for the ensemble, written once against a handful of vector
+// macros. Each ensemble_*.c file defines the macros for its instruction set
+// and includes this, the same way a template would be instantiated.
+//
+// Needs: VEC, IVEC, VMASK, LANES, VLOAD, VSTORE, VSET1, VADD, VSUB, VMUL,
+// VDIV, VFMA (a * b + c), VROUND, VCVTI, VBIT (mask where an int bit is set),
+// VBLEND (mask ? a : b), VLIVE (mask where a lane is > 0), VANY (nonzero if
+// any lane of a mask is set) and KERNEL_NAME.
+
+#include "ensemble.h"
+
+// Cody-Waite split of pi/2 and minimax polynomials on [-pi/4, pi/4]
+#define K_TWO_OVER_PI 0.63661977236f
+#define K_PIO2_1 1.5703125f
+#define K_PIO2_2 4.837512969970703125e-4f
+#define K_PIO2_3 7.54978995489188216e-8f
+#define K_S1 -1.6666654611e-1f
+#define K_S2 8.3321608736e-3f
+#define K_S3 -1.9515295891e-4f
+#define K_C1 4.166664568298827e-2f
+#define K_C2 -1.388731625493765e-3f
+#define K_C3 2.443315711809948e-5f
+
+static inline void vsincos(VEC x, VEC *sinOut, VEC *cosOut) {
+	VEC q = VROUND(VMUL(x, VSET1(K_TWO_OVER_PI)));
+	VEC r = VSUB(x, VMUL(q, VSET1(K_PIO2_1)));
+	r = VSUB(r, VMUL(q, VSET1(K_PIO2_2)));
+	r = VSUB(r, VMUL(q, VSET1(K_PIO2_3)));
+	VEC r2 = VMUL(r, r);
+
+	VEC s = VFMA(r2, VSET1(K_S3), VSET1(K_S2));
+	s = VFMA(r2, s, VSET1(K_S1));
+	s = VFMA(VMUL(r2, r), s, r);
+	VEC c = VFMA(r2, VSET1(K_C3), VSET1(K_C2));
+	c = VFMA(r2, c, VSET1(K_C1));
+	c = VFMA(VMUL(r2, r2), c, VFMA(r2, VSET1(-0.5f), VSET1(1.0f)));
+
+	// sin(r + q pi/2) and cos(r + q pi/2) from the quadrant
+	IVEC qi = VCVTI(q);
+	IVEC qi1 = VCVTI(VADD(q, VSET1(1.0f)));
+	VMASK swap = VBIT(qi, 1);
+	VEC sn = VBLEND(swap, c, s);
+	VEC cs = VBLEND(swap, s, c);
+	*sinOut = VBLEND(VBIT(qi, 2), VSUB(VSET1(0.0f), sn), sn);
+	*cosOut = VBLEND(VBIT(qi1, 2), VSUB(VSET1(0.0f), cs), cs);
+}
+
+// Same equations as omegadot0 and omegadot1, sharing the trig terms
+static inline void vderiv(VEC t0, VEC w0, VEC t1, VEC w1,
+						  VEC m0, VEC m1, VEC l0, VEC l1, VEC g,
+						  VEC *a0, VEC *a1) {
+	VEC s0, c0, s1, c1, s01, c01;
+	vsincos(t0, &s0, &c0);
+	vsincos(t1, &s1, &c1);
+	vsincos(VSUB(t0, t1), &s01, &c01);
+
+	VEC m01 = VADD(m0, m1);
+	VEC den = VFMA(VMUL(m1, s01), s01, m0);
+	VEC x = VSUB(VMUL(g, s1), VMUL(VMUL(l0, VMUL(w0, w0)), s01)); // l0 w0^2 sin(t1 - t0) + g sin(t1)
+	VEC y = VFMA(VMUL(m1, VMUL(l1, VMUL(w1, w1))), s01, VMUL(m01, VMUL(g, s0)));
+	*a0 = VDIV(VSUB(VMUL(VMUL(m1, c01), x), y), VMUL(l0, den));
+	*a1 = VDIV(VSUB(VMUL(c01, y), VMUL(m01, x)), VMUL(l1, den));
+}
+
+void KERNEL_NAME(Ensemble *e, int begin, int end, float dt) {
+	VEC h = VSET1(dt);
+	VEC half = VSET1(0.5f * dt);
+	VEC sixth = VSET1(dt / 6.0f);
+	VEC two = VSET1(2.0f);
+	VEC g = VSET1(e->g);
+
+	for (int i = begin; i < end; i += LANES) {
+		// Vectors with nothing left running are skipped outright, partly
+		// finished ones are stepped and the finished lanes put back
+		VMASK live = VLIVE(VLOAD(e->active + i));
+		if (!VANY(live)) {
+			continue;
+		}
+		VEC m0 = VLOAD(e->mass0 + i);
+		VEC m1 = VLOAD(e->mass1 + i);
+		VEC l0 = VLOAD(e->length0 + i);
+		VEC l1 = VLOAD(e->length1 + i);
+		VEC t0 = VLOAD(e->theta0 + i);
+		VEC w0 = VLOAD(e->omega0 + i);
+		VEC t1 = VLOAD(e->theta1 + i);
+		VEC w1 = VLOAD(e->omega1 + i);
+
+		VEC a0_1, a1_1, a0_2, a1_2, a0_3, a1_3, a0_4, a1_4;
+		vderiv(t0, w0, t1, w1, m0, m1, l0, l1, g, &a0_1, &a1_1);
+
+		VEC w0_2 = VFMA(half, a0_1, w0);
+		VEC w1_2 = VFMA(half, a1_1, w1);
+		vderiv(VFMA(half, w0, t0), w0_2, VFMA(half, w1, t1), w1_2,
+			   m0, m1, l0, l1, g, &a0_2, &a1_2);
+
+		VEC w0_3 = VFMA(half, a0_2, w0);
+		VEC w1_3 = VFMA(half, a1_2, w1);
+		vderiv(VFMA(half, w0_2, t0), w0_3, VFMA(half, w1_2, t1), w1_3,
+			   m0, m1, l0, l1, g, &a0_3, &a1_3);
+
+		VEC w0_4 = VFMA(h, a0_3, w0);
+		VEC w1_4 = VFMA(h, a1_3, w1);
+		vderiv(VFMA(h, w0_3, t0), w0_4, VFMA(h, w1_3, t1), w1_4,
+			   m0, m1, l0, l1, g, &a0_4, &a1_4);
+
+		VEC dt0 = VADD(VADD(w0, w0_4), VMUL(two, VADD(w0_2, w0_3)));
+		VEC dt1 = VADD(VADD(w1, w1_4), VMUL(two, VADD(w1_2, w1_3)));
+		VEC dw0 = VADD(VADD(a0_1, a0_4), VMUL(two, VADD(a0_2, a0_3)));
+		VEC dw1 = VADD(VADD(a1_1, a1_4), VMUL(two, VADD(a1_2, a1_3)));
+
+		VSTORE(e->theta0 + i, VBLEND(live, VFMA(sixth, dt0, t0), t0));
+		VSTORE(e->theta1 + i, VBLEND(live, VFMA(sixth, dt1, t1), t1));
+		VSTORE(e->omega0 + i, VBLEND(live, VFMA(sixth, dw0, w0), w0));
+		VSTORE(e->omega1 + i, VBLEND(live, VFMA(sixth, dw1, w1), w1));
+	}
+}
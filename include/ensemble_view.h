@@ -0,0 +1,32 @@
+#ifndef ENSEMBLE_VIEW_H
+#define ENSEMBLE_VIEW_H
+
+// Draws every pendulum of an Ensemble straight from its arrays. Arms and bobs
+// are quads in a few big meshes, ENSEMBLE_VIEW_CHUNK pendulums to a mesh (16
+// vertices each keeps the indices in 16 bits). Each frame rewrites the
+// positions and uploads them in one go per mesh. The colors and indices
+// never change, so 10k pendulums are three draw calls. Built on raylib, so
+// this goes with the viewers rather than the library.
+
+#include "raylib.h"
+#include "ensemble.h"
+
+#define ENSEMBLE_VIEW_CHUNK 4096
+#define ENSEMBLE_VIEW_ARM 0.5f // half the width of an arm in pixels
+#define ENSEMBLE_VIEW_BOB 2.0f // half the size of a bob
+
+typedef struct EnsembleView {
+	int count;
+	int meshCount;
+	Mesh *meshes;
+	Material material;
+} EnsembleView;
+
+EnsembleView newEnsembleView(int count); // meshes is NULL if out of memory
+void freeEnsembleView(EnsembleView *view);
+// colors[id] for each pendulum, matched to the ensemble's lanes as they are
+// now and sent to the GPU right away
+void setEnsembleViewColors(EnsembleView *view, const Ensemble *ensemble, const Color colors[]);
+void drawEnsembleView(EnsembleView *view, const Ensemble *ensemble, Vector2 origin);
+
+#endif // !ENSEMBLE_VIEW_H
@@ -0,0 +1,63 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+// Renders a run to video frames without a window. The pendulum is drawn
+// into a CPU raster, so there's no GL context and no display server, and a
+// run goes as fast as the cores allow. The physics is stepped on the calling
+// thread and the frames are drawn EXPORT_BATCH_FRAMES at a time across a
+// job pool. PPM files are written by the same jobs; a raw stream or pipe is
+// written in order once the batch is drawn.
+//
+// Frames are 24-bit RGB, top row first. Frame n shows the state at n / fps
+// seconds, interpolated between the fixed steps around it like the viewers
+// do. For PNG, H.264 or anything else, pipe the raw stream into an encoder:
+//
+//   -pipe "ffmpeg -f rawvideo -pix_fmt rgb24 -s 1280x720 -r 60 -i - out.mp4"
+
+#include "pendulum.h"
+
+#define EXPORT_BATCH_FRAMES 32
+#define EXPORT_MAX_BODIES MAX_CHAIN
+
+typedef enum ExportFormat {
+	EXPORT_NONE,
+	EXPORT_PPM, // one file per frame, path is a printf pattern like "frame%05d.ppm"
+	EXPORT_RAW, // one stream of frames, path is a file or "-" for stdout
+	EXPORT_PIPE // path is a command the raw stream is written into
+} ExportFormat;
+
+typedef struct ExportOptions {
+	ExportFormat format;
+	const char *path;
+	int width;
+	int height;
+	int fps;
+	float duration; // simulated seconds
+	int threads; // 0 for one per core
+	int trail; // physics steps of trail behind the last bob, 0 for none
+
+	const Body *bodies;
+	int count;
+	real g;
+	float dt;
+	Integrator integrator;
+
+	// Where and how big. The radii are in units of length too, so they
+	// shrink and grow with the frame like the arms.
+	float originX; // pixels
+	float originY;
+	float scale; // pixels per unit of length
+	float pivotRadius;
+	const float *radius; // [count], one per bob
+} ExportOptions;
+
+// Reads -export, -raw, -pipe, -t, -fps, -w, -h, -j and -trail from the
+// command line into options, leaving anything not given alone. Returns 0
+// if there was no -export, -raw or -pipe, 1 if there was and -1 (after
+// printing why) for anything it doesn't understand.
+int parseExportArgs(int argc, char **argv, ExportOptions *options);
+// Frames written, or -1 if something couldn't be opened, allocated or written,
+// or the -pipe command exited with an error
+long long runExport(const ExportOptions *options);
+
+#endif // !EXPORT_H
@@ -0,0 +1,24 @@
+#ifndef FIXEDSTEP_H
+#define FIXEDSTEP_H
+
+// Fixed physics timestep driven by a variable frame time. Each frame adds
+// its (scaled) time to the accumulator and takes as many whole steps as fit.
+// Whatever is left over is used to interpolate between the last two states
+// when rendering, so the physics cost per simulated second doesn't depend on
+// the frame rate.
+
+#define MAX_FRAME_TIME 0.25f // longer frames than this are treated as a hitch
+
+typedef struct FixedStep {
+	float dt; // physics step in seconds
+	float accumulator; // simulated time not yet stepped
+	int maxSteps; // most steps taken in one frame before dropping time
+} FixedStep;
+
+FixedStep newFixedStep(float dt, int maxSteps);
+// Adds frameTime * speedup to the accumulator and returns how many steps to take
+int advanceFixedStep(FixedStep *clock, float frameTime, float speedup);
+// How far between the previous and current state the render should be, 0 to 1
+float getFixedStepAlpha(FixedStep clock);
+
+#endif // !FIXEDSTEP_H
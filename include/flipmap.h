@@ -0,0 +1,38 @@
+#ifndef FLIPMAP_H
+#define FLIPMAP_H
+
+#include "ensemble.h"
+#include "jobs.h"
+
+// Flip-time map of the double pendulum. Every pixel is one pendulum let go
+// from rest, with theta0 along x and theta1 along y, both over [-pi, pi]
+// (theta1 = pi at the top). Each one runs until either arm goes over the
+// top, |theta| > pi, and that time is the pixel's value.
+//
+// Pixels are run in chunks of FLIPMAP_CHUNK on the SIMD ensemble. Pendulums
+// that don't have the energy to ever flip are never simulated, the ones that
+// flip drop out of the batch (see runEnsembleRangeUntil), and a chunk stops
+// as soon as all of its pendulums have flipped.
+
+#define FLIPMAP_CHUNK 1024 // pixels per job, a multiple of ENSEMBLE_LANES
+
+#define FLIP_TIMEOUT -1.0f // still hadn't flipped at maxTime
+#define FLIP_FORBIDDEN -2.0f // not enough energy to flip at all
+
+typedef struct FlipMap {
+	int width, height;
+	Body body0, body1; // masses and lengths, the angles come from the pixel
+	float g;
+	float dt;
+	float maxTime;
+	float *time; // [width * height], row major, written by computeFlipMap
+} FlipMap;
+
+// Initial angles of pixel (x, y)
+void getFlipMapAngles(const FlipMap *map, int x, int y, real *theta0, real *theta1);
+// Can the pendulum let go from rest at these angles flip either arm?
+int canFlip(Body body0, Body body1, float g);
+// Fills map->time, returns 0 if it couldn't allocate
+int computeFlipMap(JobPool *pool, FlipMap *map);
+
+#endif // !FLIPMAP_H
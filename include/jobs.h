@@ -0,0 +1,25 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "thread.h"
+
+// Work-stealing thread pool for splitting a batch into chunks. Every worker
+// starts with an even share of the chunks and takes them from the front;
+// once it runs out it steals from the back of someone else's share. A worker
+// stuck on a slow chunk (lots of rejected adaptive steps, say) only holds on
+// to that one chunk, the rest of its share gets picked up by the others.
+//
+// The calling thread works as worker 0, so a pool of 1 runs everything
+// inline without starting any threads.
+
+typedef void (*JobFn)(void *ctx, int chunk, int worker);
+
+typedef struct JobPool JobPool;
+
+JobPool *newJobPool(int workers); // 0 or less for one per core, NULL on failure
+void freeJobPool(JobPool *pool);
+int getJobPoolSize(const JobPool *pool);
+// Calls fn(ctx, chunk, worker) for every chunk in [0, chunks) and returns once all are done
+void runJobs(JobPool *pool, int chunks, JobFn fn, void *ctx);
+
+#endif // !JOBS_H
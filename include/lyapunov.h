@@ -0,0 +1,39 @@
+#ifndef LYAPUNOV_H
+#define LYAPUNOV_H
+
+#include "pendulum.h"
+
+// Lyapunov spectrum of the double pendulum from the variational equations.
+// Four tangent vectors are carried along with the state and pushed forward
+// by the Jacobian of doubleDerivative, then Gram-Schmidt orthonormalized
+// every so often. Each exponent is the average log stretch of its direction.
+// The Jacobian shares its trig with the derivative, so the whole spectrum
+// costs a few multiply-adds per stage on top of the plain RK4 step, instead
+// of one or more extra trajectories like the twin-trajectory method.
+
+#define LYAPUNOV_DIM 4
+#define LYAPUNOV_STATE (LYAPUNOV_DIM * (LYAPUNOV_DIM + 1)) // y, then the tangent vectors
+#define LYAPUNOV_RENORM 10 // steps between orthonormalizations
+
+typedef struct Lyapunov {
+	DoubleParams params;
+	real y[LYAPUNOV_STATE];
+	real sum[LYAPUNOV_DIM]; // log stretch of each direction so far
+	real sumTime; // time covered by sum, up to the last orthonormalization
+	real time;
+	int steps; // since the last orthonormalization
+} Lyapunov;
+
+// d/dy of doubleDerivative, row major
+void doubleJacobian(const real y[4], const DoubleParams *params, real jacobian[16]);
+// Derivative of the state and the tangent vectors together, y is LYAPUNOV_STATE long
+void lyapunovDerivative(const real y[], real dydt[], const void *params);
+
+void initLyapunov(Lyapunov *lyapunov, Body body0, Body body1, real g);
+// One RK4 step of dt for the state and the tangent vectors
+void stepLyapunov(Lyapunov *lyapunov, real dt);
+void getLyapunovBodies(const Lyapunov *lyapunov, Body *body0, Body *body1);
+// Largest first. They're averages, so they take a while to settle down.
+void getLyapunovSpectrum(const Lyapunov *lyapunov, real spectrum[LYAPUNOV_DIM]);
+
+#endif // !LYAPUNOV_H
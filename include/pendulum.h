@@ -0,0 +1,96 @@
+#ifndef PENDULUM_H
+#define PENDULUM_H
+
+// Pendulum physics shared by all the simulations. Nothing in here touches
+// raylib, so it can be built on its own as libpendulum for batch jobs.
+// Everything is in real, see real.h for the precision modes.
+
+#include "real.h"
+
+#define MAX_CHAIN 1024 // most links solveChain will take
+
+typedef enum Integrator {
+	EULER,
+	RK4,
+	RK45, // adaptive Dormand-Prince, see dopri.h
+	VERLET, // symplectic, see symplectic.h
+	YOSHIDA4,
+	YOSHIDA6,
+	INTEGRATOR_COUNT
+} Integrator;
+
+const char *getIntegratorName(Integrator integrator);
+
+typedef struct Body {
+	real mass; // in kilograms
+	real length; // in meters
+	real theta; // angle from the vertical in radians
+	real omega; // radians per second
+} Body;
+
+// Blend between two states of the same body, for rendering between steps
+Body interpolateBody(Body prev, Body curr, real alpha);
+
+// Single pendulum
+real singleAlpha(Body body, real g); // f in dx/dt = f(x, t) in numerical integration
+void solveSingle(Body *body, real g, real dt, Integrator integrator);
+real getSingleEnergy(Body body, real g);
+
+// Single pendulum as a state vector {theta, omega}
+typedef struct SingleParams {
+	real length;
+	real g;
+} SingleParams;
+
+void singleDerivative(const real y[], real dydt[], const void *params);
+
+// Double pendulum
+real omegadot0(Body body0, Body body1, real g);
+real thetadot0(Body body0, Body body1);
+real omegadot1(Body body0, Body body1, real g);
+real thetadot1(Body body0, Body body1);
+// With RK45 the bodies come back NaN if the integrator gave up on the step
+void solveDouble(Body *body0, Body *body1, real g, real dt, Integrator integrator);
+real getDoubleEnergy(Body body0, Body body1, real g);
+
+// Double pendulum as a state vector {theta0, omega0, theta1, omega1}, for
+// the generic integrators
+typedef struct DoubleParams {
+	real m0, m1;
+	real l0, l1;
+	real g;
+} DoubleParams;
+
+#define DOUBLE_TOL 1e-5f // default RK45 tolerance for solveDouble
+
+DoubleParams getDoubleParams(Body body0, Body body1, real g);
+void packDouble(Body body0, Body body1, real y[4]);
+void unpackDouble(const real y[4], Body *body0, Body *body1);
+void doubleDerivative(const real y[], real dydt[], const void *params);
+
+// N-link chain, angles are absolute like the double pendulum. Only EULER
+// and RK4 are implemented here, anything else steps with RK4. Both return 0
+// and leave their output alone unless 1 <= count <= MAX_CHAIN.
+int chainAlpha(const Body bodies[], int count, real g, real alpha[]);
+int solveChain(Body bodies[], int count, real g, real dt, Integrator integrator);
+real getChainEnergy(const Body bodies[], int count, real g);
+
+// Any of the above by body count: one is a single pendulum, two a double
+// and more a chain. Returns 0 for more than MAX_CHAIN.
+int solveSystem(Body bodies[], int count, real g, real dt, Integrator integrator);
+real getSystemEnergy(const Body bodies[], int count, real g);
+
+// Chain as a state vector {theta0, omega0, theta1, omega1, ...}, laid out
+// like the double pendulum's, for the generic integrators. Masses and
+// lengths are read from bodies, their angles are ignored.
+typedef struct ChainParams {
+	const Body *bodies;
+	int count;
+	real g;
+} ChainParams;
+
+void packChain(const Body bodies[], int count, real y[]);
+void unpackChain(const real y[], int count, Body bodies[]);
+void chainDerivative(const real y[], real dydt[], const void *params);
+
+#endif // !PENDULUM_H
@@ -0,0 +1,43 @@
+#ifndef POINCARE_H
+#define POINCARE_H
+
+#include "pendulum.h"
+#include "dopri.h"
+#include "jobs.h"
+
+// Poincare sections of the double pendulum. Each run is integrated with
+// RK45 and every crossing of the section is located on the dense output
+// (see locateDopriEvent), then appended to a point buffer. Only the crossings
+// are kept, never the trajectory, so a section can have millions of points.
+//
+// The section is theta0 = 0 (mod 2 pi) going right, omega0 > 0. It's found as
+// a rising zero of sin(theta0), since theta0 isn't wrapped, keeping only
+// the ones where cos(theta0) > 0.
+
+typedef struct PoincarePoint {
+	int run; // which initial condition it came from
+	float t;
+	float theta0, omega0, theta1, omega1;
+} PoincarePoint;
+
+typedef struct PoincareBuffer {
+	PoincarePoint *points;
+	long long count;
+	long long capacity;
+} PoincareBuffer;
+
+void pushPoincarePoint(PoincareBuffer *buffer, PoincarePoint point); // grows as needed
+void freePoincareBuffer(PoincareBuffer *buffer);
+
+// sin(theta0), the event for the section
+real poincareEvent(const real y[], const void *ctx);
+// One run for duration seconds, appending its crossings. Returns how many it
+// found, up to wherever the integrator gave up if it did.
+long long sectionDouble(Body body0, Body body1, real g, real duration, real tol,
+						int run, PoincareBuffer *out);
+// bodies[i][0] and bodies[i][1] for each run, spread over the pool. The points
+// come out grouped by worker, not by run; sort on run if the order matters.
+void runPoincare(JobPool *pool, const Body (*bodies)[2], int count, real g,
+				 real duration, real tol, PoincareBuffer *out);
+
+#endif // !POINCARE_H
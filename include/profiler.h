@@ -0,0 +1,46 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Per-frame timings for the viewers, split into phases. PROFILE_FRAME()
+// goes at the top of the frame loop and closes the last frame, and the
+// PROFILE_BEGIN/PROFILE_END pairs around each phase add to the current one.
+// The last PROFILE_HISTORY frames are kept in a ring for drawProfiler (ui.h).
+//
+// The macros only do anything with PENDULUM_PROFILE defined (set PROFILE=1
+// before make.bat). Otherwise they're empty and the viewers don't call into
+// any of this at all.
+
+#define PROFILE_HISTORY 240 // frames
+
+typedef enum ProfilePhase {
+	PHASE_INPUT,
+	PHASE_PHYSICS,
+	PHASE_UI,
+	PHASE_RENDER,
+	PHASE_COUNT
+} ProfilePhase;
+
+typedef struct ProfileFrame {
+	float phase[PHASE_COUNT]; // seconds spent in each phase
+	float total; // start of this frame to the start of the next, vsync included
+} ProfileFrame;
+
+const char *getPhaseName(ProfilePhase phase);
+void profileFrame(void);
+void profileBegin(ProfilePhase phase);
+void profileEnd(ProfilePhase phase);
+// n = 0 is the last finished frame, up to getProfileFrameCount() - 1
+const ProfileFrame *getProfileFrame(int n);
+int getProfileFrameCount(void);
+
+#ifdef PENDULUM_PROFILE
+#define PROFILE_FRAME() profileFrame()
+#define PROFILE_BEGIN(phase) profileBegin(phase)
+#define PROFILE_END(phase) profileEnd(phase)
+#else
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+#endif
+
+#endif // !PROFILER_H
@@ -0,0 +1,66 @@
+#ifndef REAL_H
+#define REAL_H
+
+#include <float.h>
+#include <math.h>
+
+// Scalar types for the physics, picked at build time:
+//
+//   default              float state, float derivatives
+//   PENDULUM_DOUBLE      double state, double derivatives
+//   PENDULUM_MIXED       double state and accumulation, float derivatives
+//
+// "real" is what states, steps and integrator sums are stored in. "evalReal"
+// is what the derivative kernels (singleAlpha, doubleDerivative, chainAlpha,
+// ...) do their math in. With make, pass PRECISION=double or PRECISION=mixed.
+// The SIMD ensemble kernel and the .traj files are float in every mode.
+
+#if defined(PENDULUM_DOUBLE)
+typedef double real;
+typedef double evalReal;
+#define REAL_NAME "double"
+#elif defined(PENDULUM_MIXED)
+typedef double real;
+typedef float evalReal;
+#define REAL_NAME "mixed"
+#else
+typedef float real;
+typedef float evalReal;
+#define REAL_NAME "float"
+#endif
+
+#if defined(PENDULUM_DOUBLE) || defined(PENDULUM_MIXED)
+#define realSin sin
+#define realCos cos
+#define realSqrt sqrt
+#define realAbs fabs
+#define realPow pow
+#define realFloor floor
+#define realLog log
+#define realMin fmin
+#define realMax fmax
+#define REAL_EPSILON DBL_EPSILON
+#else
+#define realSin sinf
+#define realCos cosf
+#define realSqrt sqrtf
+#define realAbs fabsf
+#define realPow powf
+#define realFloor floorf
+#define realLog logf
+#define realMin fminf
+#define realMax fmaxf
+#define REAL_EPSILON FLT_EPSILON
+#endif
+
+#if defined(PENDULUM_DOUBLE)
+#define evalSin sin
+#define evalCos cos
+#define EVAL_EPSILON DBL_EPSILON
+#else
+#define evalSin sinf
+#define evalCos cosf
+#define EVAL_EPSILON FLT_EPSILON
+#endif
+
+#endif // !REAL_H
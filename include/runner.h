@@ -0,0 +1,34 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include "ensemble.h"
+#include "jobs.h"
+
+// Runs a whole ensemble across a job pool. The ensemble is cut into chunks
+// of RUNNER_CHUNK pendulums and each chunk is taken all the way to the end
+// before moving on, so its arrays stay in cache.
+
+#define RUNNER_CHUNK 1024 // pendulums per chunk, a multiple of ENSEMBLE_LANES
+
+// steps fixed RK4 steps of dt on the SIMD kernel
+void runEnsemble(JobPool *pool, Ensemble *ensemble, float dt, int steps);
+// Each pendulum runs its own adaptive RK45 for duration seconds, so some
+// chunks can take much longer than others. One the integrator gives up on
+// ends up NaN.
+void runEnsembleAdaptive(JobPool *pool, Ensemble *ensemble, float duration, float tol);
+
+// Nonzero once lane i should stop (ensemble->id[i] says which pendulum it is)
+typedef int (*EnsembleEvent)(void *ctx, const Ensemble *ensemble, int i);
+
+// Up to steps RK4 steps of dt, asking event about every active pendulum after
+// each one. A pendulum whose event fires is switched off right there, and
+// stopStep[id] (if not NULL) gets the step it stopped on, 0 if it never did.
+// Finished lanes get compacted out as they pile up, so afterwards lanes are
+// shuffled within each chunk; use id to find a pendulum.
+void runEnsembleUntil(JobPool *pool, Ensemble *ensemble, float dt, int steps,
+					  EnsembleEvent event, void *ctx, int stopStep[]);
+// Same for pendulums [begin, end) on the calling thread, begin a multiple of ENSEMBLE_LANES
+void runEnsembleRangeUntil(Ensemble *ensemble, int begin, int end, float dt, int steps,
+						   EnsembleEvent event, void *ctx, int stopStep[]);
+
+#endif // !RUNNER_H
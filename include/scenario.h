@@ -0,0 +1,90 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+// Scenario files (.scn): the starting state of a run, and optionally a
+// sweep of runs around it. Plain text, one setting per line, # starts a
+// comment, angles in radians:
+//
+//   g 200
+//   dt 0.004166667
+//   integrator RK4                  any name from getIntegratorName, spaces left out
+//   body 10 100 1.2566 0            mass length theta [omega], top of the chain first
+//   body 5 100 2.5133
+//   ensemble 100 0.01               grid side and spread in radians, for the E view
+//   vary theta1 0 3.14159 1000      parameter min max count, a Cartesian sweep axis
+//   runs theta0 theta1 mass1        columns, every line after this is one run
+//   0.1 0.2 5
+//   ...
+//
+// Anything left out keeps its default, g 9.81, dt 1/240 and RK4, but there
+// has to be at least one body. Parameters are g, or mass, length, theta or
+// omega followed by the index of a body listed above them.
+//
+// The settings are read when the file is opened. Runs after a runs line are
+// then streamed a row at a time out of one fixed buffer, so a file with
+// millions of them starts at once and never has to fit in memory.
+
+#include "pendulum.h"
+
+#define SCENARIO_MAX_BODIES MAX_CHAIN
+#define SCENARIO_MAX_AXES 8
+#define SCENARIO_MAX_COLUMNS 32
+#define SCENARIO_BUFFER (1 << 20) // bytes read at a time, also the longest line
+
+typedef enum ScenarioField {
+	SCENARIO_G,
+	SCENARIO_MASS,
+	SCENARIO_LENGTH,
+	SCENARIO_THETA,
+	SCENARIO_OMEGA
+} ScenarioField;
+
+typedef struct ScenarioParam {
+	ScenarioField field;
+	int body; // unused for g
+} ScenarioParam;
+
+typedef struct ScenarioAxis {
+	ScenarioParam param;
+	real min;
+	real max;
+	int count; // values from min to max inclusive
+} ScenarioAxis;
+
+typedef struct Scenario {
+	Body bodies[SCENARIO_MAX_BODIES];
+	int count;
+	real g;
+	float dt;
+	Integrator integrator;
+
+	int ensembleSide; // 0 if the file doesn't say
+	float ensembleSpread;
+
+	ScenarioAxis axes[SCENARIO_MAX_AXES];
+	int axisCount;
+
+	ScenarioParam columns[SCENARIO_MAX_COLUMNS]; // of the runs, if there are any
+	int columnCount;
+} Scenario;
+
+typedef struct ScenarioFile ScenarioFile;
+
+// Reads the settings into scenario, up to the first run. NULL (after
+// printing the file, line and why) if it can't be opened or doesn't parse.
+ScenarioFile *openScenario(const char *path, Scenario *scenario);
+// Reads the next run's values, one per column. Returns 1 for a run, 0 at the
+// end of the file and -1 (after printing why) for a bad line.
+int readScenarioRun(ScenarioFile *file, real values[]);
+long long getScenarioLine(const ScenarioFile *file);
+void closeScenario(ScenarioFile *file);
+
+// Just the settings, for the viewers. 0 on failure.
+int loadScenario(const char *path, Scenario *scenario);
+
+// Sets one parameter of a run
+void setScenarioParam(Body bodies[], real *g, ScenarioParam param, real value);
+// "theta1" and so on, for headers. name needs room for 16 characters.
+void getScenarioParamName(ScenarioParam param, char name[16]);
+
+#endif // !SCENARIO_H
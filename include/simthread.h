@@ -0,0 +1,87 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+// Runs the physics on its own thread at its own fixed rate, so the renderer
+// waiting on vsync no longer holds the simulation back and a fast speedup
+// doesn't eat into the frame.
+//
+// States go to the render thread through a triple buffer: the physics
+// thread fills a back slot and swaps it with the middle one, the renderer
+// swaps its front slot with the middle one whenever there is something new.
+// Neither side ever waits for the other and the renderer always gets the
+// latest whole state. Settings going the other way (speed, integrator, new
+// bodies) are left in a mailbox the physics thread empties between batches.
+// Its mutex is only held for a copy, so setting them never waits on a batch.
+//
+// Time warp: each batch may spend SIM_BUDGET of the wall time since the
+// last one stepping, and whatever doesn't fit is dropped, so the achieved
+// warp falls short of the requested one instead of the thread falling
+// further and further behind. After SIM_SWITCH_BATCHES batches in a row over
+// budget it moves to an integrator that covers more simulated time per
+// second of CPU: Verlet for the costly symplectic ones, then RK45, whose
+// steps grow far past the fixed dt when the motion allows. It goes back to
+// the chosen integrator once that is predicted to fit in SIM_RELAX_LOAD of
+// the budget again.
+
+#include "pendulum.h"
+#include "fixedstep.h"
+#include "trajectory.h"
+
+#define SIM_MAX_BODIES MAX_CHAIN
+#define SIM_IDLE 0.002f // seconds the physics thread sleeps at most between checks
+#define SIM_RK45_TOL 1e-5f
+#define SIM_BUDGET 0.9f
+#define SIM_SWITCH_BATCHES 32
+#define SIM_RELAX_LOAD 0.5f
+#define SIM_WARP_WINDOW 0.25f // seconds of wall time the achieved warp is averaged over
+#define SIM_PATH_POINTS 4096 // most steps' tips a frame carries, the newest are kept
+
+// One published state
+typedef struct SimFrame {
+	double time; // simulated time of bodies, double so long warps don't stall it
+	long long steps; // steps taken since the last reset
+	int stepsLast; // steps in the last batch
+	float speedup; // requested warp
+	float warp; // achieved warp, simulated seconds per wall second
+	float load; // fraction of the budget spent stepping
+	Integrator integrator; // the one in use, which the warp may have switched
+	float alpha; // how far between prev and bodies the render should be
+	int count;
+	Body prev[SIM_MAX_BODIES];
+	Body bodies[SIM_MAX_BODIES];
+
+	// Where the end of the last body was after each recent step, oldest
+	// first, relative to the pivot (l sin theta, l cos theta summed down the
+	// chain). Points are numbered over the whole life of the thread and
+	// these are pathCount of them up to pathEnd, starting at least from
+	// where the last frame the renderer took ended. Frames can overlap, so
+	// only use the points past the last pathEnd seen.
+	long long pathEnd;
+	int pathCount;
+	float pathX[SIM_PATH_POINTS];
+	float pathY[SIM_PATH_POINTS];
+} SimFrame;
+
+typedef struct SimThread SimThread;
+
+// One body uses solveSingle, two solveDouble and more solveChain, RK45 runs
+// one Dopri over the whole state with dense output. Starts paused, NULL on
+// failure.
+SimThread *startSimThread(const Body bodies[], int count, real g, float dt, Integrator integrator);
+void stopSimThread(SimThread *sim);
+
+// The latest state, valid until the next call. Only the render thread may call this.
+const SimFrame *readSimFrame(SimThread *sim);
+
+void setSimRunning(SimThread *sim, int running);
+void setSimSpeed(SimThread *sim, float speedup);
+// The integrator to use whenever the warp allows
+void setSimIntegrator(SimThread *sim, Integrator integrator);
+// Replaces the bodies and starts the time over
+void resetSim(SimThread *sim, const Body bodies[]);
+// Frames get recorded from the physics thread. Returns the recorder it was
+// using, which the physics thread has let go of by the time this returns,
+// so this one waits for the batch in flight to finish.
+Recorder *setSimRecorder(SimThread *sim, Recorder *recorder);
+
+#endif // !SIMTHREAD_H
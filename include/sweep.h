@@ -0,0 +1,71 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+// Parameter sweeps over the double pendulum. Each run starts from a base
+// state with some of its parameters (see ScenarioParam) replaced, is stepped
+// for a fixed time, and boils down to a few numbers: how far the energy
+// wandered, how often and how soon an arm went over the top, and the largest
+// Lyapunov exponent.
+//
+// Runs come from a scenario's vary axes, either every combination of them
+// or a Latin hypercube sample of their ranges, or from its runs table.
+// Either way they're measured SWEEP_BATCH at a time across a job pool,
+// so memory stays flat however many there are.
+
+#include "jobs.h"
+#include "scenario.h"
+
+#define SWEEP_BATCH 4096
+#define SWEEP_NO_FLIP -1.0f
+
+typedef struct SweepMetrics {
+	real maxDrift; // largest |E - E0| / |E0| seen
+	int flips; // times either arm went over the top
+	real firstFlip; // time of the first one, SWEEP_NO_FLIP if there wasn't one
+	real lyapunov; // largest exponent at the end, in 1/s
+} SweepMetrics;
+
+typedef struct Sweep {
+	Body body0, body1; // what every run starts from
+	real g;
+	float dt;
+	Integrator integrator;
+	float duration; // simulated seconds per run
+
+	const ScenarioParam *params; // what each run changes
+	int paramCount;
+	const real *values; // [count][paramCount]
+	SweepMetrics *metrics; // [count], written by runSweep
+	int count;
+} Sweep;
+
+// One run. The Lyapunov exponent always comes from RK4 on the variational
+// equations. With any other integrator the run is stepped a second time
+// for the other metrics.
+SweepMetrics measureRun(Body body0, Body body1, real g, float dt, Integrator integrator, float duration);
+// Measures all of sweep's runs in parallel
+void runSweep(JobPool *pool, const Sweep *sweep);
+
+// Every combination of the axes, the last one varying fastest. An axis with
+// a count of one sits at its min.
+long long getCartesianCount(const ScenarioAxis axes[], int axisCount);
+void getCartesianRun(const ScenarioAxis axes[], int axisCount, long long index, real values[]);
+
+// Latin hypercube: each axis's range is cut into samples equal strata and
+// every stratum of every axis is used exactly once, in an order shuffled
+// per axis. Far fewer runs than a grid cover the same ranges evenly. The
+// same seed gives the same runs.
+typedef struct LatinHypercube {
+	ScenarioAxis axes[SCENARIO_MAX_AXES];
+	int axisCount;
+	int samples;
+	unsigned long long seed;
+	int *strata; // [axisCount][samples]
+} LatinHypercube;
+
+int newLatinHypercube(LatinHypercube *lhs, const ScenarioAxis axes[], int axisCount,
+					  int samples, unsigned long long seed); // 0 if it couldn't allocate
+void getLatinHypercubeRun(const LatinHypercube *lhs, long long index, real values[]);
+void freeLatinHypercube(LatinHypercube *lhs);
+
+#endif // !SWEEP_H
@@ -0,0 +1,26 @@
+#ifndef SYMPLECTIC_H
+#define SYMPLECTIC_H
+
+#include "pendulum.h"
+
+// Symplectic steppers for long runs. Unlike RK4 these don't let the energy
+// drift away over time, the error just oscillates around the starting value,
+// so they stay usable at a much larger dt.
+//
+// The single pendulum's Hamiltonian is separable, so plain Stormer-Verlet
+// (kick, drift, kick) works. The double pendulum's kinetic energy depends on
+// theta0 - theta1, so it uses the generalized leapfrog on (theta, p) instead,
+// which solves its two implicit half steps with a few fixed-point iterations.
+// Yoshida's triple jump composes either one into a 4th or 6th order method.
+
+#define VERLET_MAX_ITER 16
+#define VERLET_TOL (4 * EVAL_EPSILON) // the forces are only as exact as evalReal
+
+void verletSingle(Body *body, real g, real dt);
+void verletDouble(Body *body0, Body *body1, real g, real dt);
+
+// order is 2 (plain Verlet), 4 or 6
+void yoshidaSingle(Body *body, real g, real dt, int order);
+void yoshidaDouble(Body *body0, Body *body1, real g, real dt, int order);
+
+#endif // !SYMPLECTIC_H
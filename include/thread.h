@@ -0,0 +1,77 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+// Just enough threading for the batch runners: threads, a mutex and
+// condition variable for parking idle threads, and 64-bit atomics. Windows
+// types stay inside thread.c so this can be included next to raylib.h.
+
+typedef struct Thread {
+	void *handle;
+} Thread;
+
+typedef struct Mutex Mutex;
+typedef struct Cond Cond;
+
+int startThread(Thread *thread, void (*fn)(void *arg), void *arg); // 0 on failure
+void joinThread(Thread thread);
+void yieldThread(void);
+void sleepThread(float seconds);
+int getCpuCount(void);
+double getClock(void); // monotonic seconds from some fixed point, for timing
+
+Mutex *newMutex(void);
+void freeMutex(Mutex *mutex);
+void lockMutex(Mutex *mutex);
+void unlockMutex(Mutex *mutex);
+
+Cond *newCond(void);
+void freeCond(Cond *cond);
+void waitCond(Cond *cond, Mutex *mutex);
+void signalCond(Cond *cond);
+void broadcastCond(Cond *cond);
+
+typedef struct Atomic64 {
+	volatile long long value;
+} Atomic64;
+
+// All of these are sequentially consistent
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline long long atomicLoad(Atomic64 *a) {
+	return _InterlockedCompareExchange64(&a->value, 0, 0);
+}
+static inline void atomicStore(Atomic64 *a, long long v) {
+	_InterlockedExchange64(&a->value, v);
+}
+static inline long long atomicAdd(Atomic64 *a, long long v) { // returns the old value
+	return _InterlockedExchangeAdd64(&a->value, v);
+}
+static inline long long atomicExchange(Atomic64 *a, long long v) { // returns the old value
+	return _InterlockedExchange64(&a->value, v);
+}
+static inline int atomicCas(Atomic64 *a, long long *expected, long long desired) {
+	long long old = _InterlockedCompareExchange64(&a->value, desired, *expected);
+	if (old == *expected) return 1;
+	*expected = old;
+	return 0;
+}
+#else
+static inline long long atomicLoad(Atomic64 *a) {
+	return __atomic_load_n(&a->value, __ATOMIC_SEQ_CST);
+}
+static inline void atomicStore(Atomic64 *a, long long v) {
+	__atomic_store_n(&a->value, v, __ATOMIC_SEQ_CST);
+}
+static inline long long atomicAdd(Atomic64 *a, long long v) { // returns the old value
+	return __atomic_fetch_add(&a->value, v, __ATOMIC_SEQ_CST);
+}
+static inline long long atomicExchange(Atomic64 *a, long long v) { // returns the old value
+	return __atomic_exchange_n(&a->value, v, __ATOMIC_SEQ_CST);
+}
+static inline int atomicCas(Atomic64 *a, long long *expected, long long desired) {
+	return __atomic_compare_exchange_n(&a->value, expected, desired, 0,
+									   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#endif
+
+#endif // !THREAD_H
@@ -0,0 +1,36 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Chrome trace export (chrome://tracing, ui.perfetto.dev). Spans and
+// counters are pushed from any thread into that thread's own buffer, which
+// only it writes, so nothing takes a lock; stopTrace reads every buffer up
+// to its published count and writes the JSON. A thread's buffer is made the
+// first time it traces, and events past TRACE_BUFFER_EVENTS are dropped.
+//
+// The macros cost one flag check while tracing is off. Names have to be
+// string literals or otherwise outlive the trace, only the pointer is kept.
+
+#define TRACE_MAX_THREADS 64
+#define TRACE_BUFFER_EVENTS (1 << 18) // per thread, 32 bytes each
+
+extern volatile int traceEnabled;
+
+// Starts a new trace. Anything still in the buffers from the last one is
+// thrown away, so no other thread should be tracing at that moment.
+void startTrace(void);
+// Stops tracing and writes everything recorded since startTrace. Returns the
+// number of events written, or -1 if the file couldn't be written.
+long long stopTrace(const char *path);
+long long getTraceDropped(void);
+// Shown as the thread's name in the trace, copied
+void setTraceThreadName(const char *name);
+
+void traceBegin(const char *name);
+void traceEnd(const char *name);
+void traceCounter(const char *name, double value);
+
+#define TRACE_BEGIN(name) do { if (traceEnabled) traceBegin(name); } while (0)
+#define TRACE_END(name) do { if (traceEnabled) traceEnd(name); } while (0)
+#define TRACE_COUNTER(name, value) do { if (traceEnabled) traceCounter(name, value); } while (0)
+
+#endif // !TRACE_H
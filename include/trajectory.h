@@ -0,0 +1,99 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stdint.h>
+#include "pendulum.h"
+
+// Binary trajectory files (.traj), in native byte order:
+//
+//   TrajHeader
+//   float mass[bodyCount], float length[bodyCount]
+//   frames until the end of the file, each frameSize bytes, see TrajFrame
+//
+// Frames have a fixed size so frame n is always at headerSize + n * frameSize.
+// Each one carries the physics step it was taken after, so a fixed-step
+// recording can be indexed by step even where frames were dropped, and its
+// time as a double, which stays finer than dt however long the run goes.
+
+#define TRAJ_MAGIC 0x4C444E50 // "PNDL"
+#define TRAJ_VERSION 2
+
+typedef struct TrajHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize; // bytes before the first frame
+	uint32_t frameSize; // bytes per frame
+	uint32_t bodyCount;
+	uint32_t integrator;
+	float dt; // physics step, 0 if it varies
+	float g;
+} TrajHeader;
+
+typedef struct TrajFrame {
+	double time;
+	int64_t step; // physics steps since the simulation was last reset
+	float energy;
+	float unused; // keeps the frames 8 byte aligned
+	float bodies[]; // {theta, omega} per body
+} TrajFrame;
+
+#define TRAJ_FRAME_SIZE(bodyCount) (sizeof(TrajFrame) + 2 * sizeof(float) * (bodyCount))
+
+// Recorder: the simulation pushes frames into a lock-free ring buffer and a
+// background thread drains it to disk. If the writer falls far enough behind
+// for the ring to fill up, frames are dropped and counted instead of making
+// the simulation wait.
+
+#define RECORDER_RING_FRAMES (1 << 16)
+
+typedef struct Recorder Recorder;
+
+Recorder *startRecorder(const char *path, const Body bodies[], int bodyCount,
+						float g, float dt, Integrator integrator); // NULL on failure
+void recordFrame(Recorder *recorder, double time, long long step, const Body bodies[], float energy);
+// Writes out whatever is still in the ring and closes the file
+void stopRecorder(Recorder *recorder);
+long long getRecorderFrames(Recorder *recorder);
+long long getRecorderDropped(Recorder *recorder);
+
+// Reader: memory-maps a recorded file so multi-GB runs can be replayed and
+// analysed without reading them in. Any frame is one multiply away, and the
+// float columns are strided views straight into the mapping.
+
+typedef struct Trajectory {
+	const TrajHeader *header;
+	const float *mass; // [bodyCount]
+	const float *length; // [bodyCount]
+	const unsigned char *frames;
+	long long frameCount;
+
+	void *map;
+	long long mapSize;
+	void *handle; // platform file mapping handle
+} Trajectory;
+
+// Element i is base[i * stride], for i in [0, count)
+typedef struct TrajColumn {
+	const float *base;
+	long long stride;
+	long long count;
+} TrajColumn;
+
+int openTrajectory(Trajectory *traj, const char *path); // 0 on failure
+void closeTrajectory(Trajectory *traj);
+const TrajFrame *getTrajFrame(const Trajectory *traj, long long n);
+void getTrajBodies(const Trajectory *traj, long long n, Body bodies[]);
+// Last frame at or before step. Frame n is step n past the first one until
+// a frame gets dropped, after that it's a binary search on the steps.
+long long findTrajStep(const Trajectory *traj, long long step);
+// Last frame at or before time. For fixed-step recordings this turns the
+// time into a step and uses findTrajStep. Adaptive ones (dt == 0), or a
+// step that doesn't land on it, fall back to a binary search on the times.
+long long findTrajFrame(const Trajectory *traj, double time);
+double getTrajDuration(const Trajectory *traj);
+
+TrajColumn getTrajEnergy(const Trajectory *traj);
+TrajColumn getTrajTheta(const Trajectory *traj, int body);
+TrajColumn getTrajOmega(const Trajectory *traj, int body);
+
+#endif // !TRAJECTORY_H
@@ -3,6 +3,7 @@
 
 // Make sure this file is in the same folder as raylib.h
 #include "raylib.h"
+#include "profiler.h"
 
 #define TEXT_L 86
 #define TEXT_M 60
@@ -50,4 +51,35 @@ Button newButton(int posX, int posY, int width, int height, float round,
 void drawButton(Button btn, Font font);
 void handleButton(Button *button, void *state);
 
+#define PROFILER_BAR 2 // pixels per frame
+#define PROFILER_HEIGHT 160
+#define PROFILER_SCALE (1.0f / 30.0f) // seconds at the top of the graph
+
+// Stacked bar per frame for the last PROFILE_HISTORY frames, newest on the
+// right, with the average of each phase above it
+void drawProfiler(int posX, int posY);
+
+// Trail of past positions in a ring preallocated for capacity points, so
+// pushing never allocates. Each point is stored twice, capacity apart, which
+// keeps any run of the newest points contiguous however the ring has
+// wrapped. Drawing fades from transparent at the oldest end to color at the
+// newest in TRAIL_BANDS steps, each one DrawLineStrip. raylib batches the
+// lines together, so the whole trail is a handful of draw calls.
+#define TRAIL_BANDS 32
+#define TRAIL_MIN_STEP 0.5f // pixels a point has to move to be kept
+
+typedef struct Trail {
+	Vector2 *points; // 2 * capacity
+	int capacity;
+	int head; // next slot written
+	int count;
+	Color color;
+} Trail;
+
+Trail newTrail(int capacity, Color color); // points is NULL if out of memory
+void freeTrail(Trail *trail);
+void clearTrail(Trail *trail);
+void pushTrail(Trail *trail, Vector2 point);
+void drawTrail(Trail trail);
+
 #endif // !UI_H
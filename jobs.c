@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "include/jobs.h"
+#include "include/trace.h"
+
+// Each worker's share is [head, tail) packed into one 64-bit word, so the
+// owner taking from the head and a thief taking from the tail can't both
+// get the last chunk.
+#define PACK(head, tail) (((long long)(tail) << 32) | (unsigned int)(head))
+#define HEAD(range) ((int)((range) & 0xFFFFFFFF))
+#define TAIL(range) ((int)((range) >> 32))
+
+typedef struct Worker {
+	Atomic64 range;
+	char pad[64 - sizeof(Atomic64)]; // keep each share on its own cache line
+} Worker;
+
+struct JobPool {
+	int size;
+	Thread *threads;
+	Worker *workers;
+
+	// Only used to park idle threads between runs
+	Mutex *lock;
+	Cond *wake;
+	Cond *done;
+	long long generation;
+	int quit;
+
+	JobFn fn;
+	void *ctx;
+	Atomic64 remaining;
+};
+
+typedef struct WorkerStart {
+	JobPool *pool;
+	int id;
+} WorkerStart;
+
+static int takeChunk(Worker *worker) {
+	long long range = atomicLoad(&worker->range);
+	while (HEAD(range) < TAIL(range)) {
+		if (atomicCas(&worker->range, &range, PACK(HEAD(range) + 1, TAIL(range)))) {
+			return HEAD(range);
+		}
+	}
+	return -1;
+}
+
+static int stealChunk(Worker *victim) {
+	long long range = atomicLoad(&victim->range);
+	while (HEAD(range) < TAIL(range)) {
+		if (atomicCas(&victim->range, &range, PACK(HEAD(range), TAIL(range) - 1))) {
+			return TAIL(range) - 1;
+		}
+	}
+	return -1;
+}
+
+static void finishChunk(JobPool *pool) {
+	if (atomicAdd(&pool->remaining, -1) == 1) {
+		lockMutex(pool->lock);
+		broadcastCond(pool->done);
+		unlockMutex(pool->lock);
+	}
+}
+
+static void work(JobPool *pool, int id) {
+	for (;;) {
+		int chunk = takeChunk(&pool->workers[id]);
+		for (int i = 1; chunk < 0 && i < pool->size; ++i) {
+			chunk = stealChunk(&pool->workers[(id + i) % pool->size]);
+		}
+		if (chunk < 0) {
+			return;
+		}
+		TRACE_BEGIN("job");
+		pool->fn(pool->ctx, chunk, id);
+		TRACE_END("job");
+		finishChunk(pool);
+	}
+}
+
+static void workerMain(void *arg) {
+	WorkerStart start = *(WorkerStart *)arg;
+	free(arg);
+	JobPool *pool = start.pool;
+	long long seen = 0;
+
+	char name[32];
+	snprintf(name, sizeof(name), "worker %d", start.id);
+	setTraceThreadName(name);
+
+	for (;;) {
+		lockMutex(pool->lock);
+		while (pool->generation == seen && !pool->quit) {
+			waitCond(pool->wake, pool->lock);
+		}
+		seen = pool->generation;
+		int quit = pool->quit;
+		unlockMutex(pool->lock);
+
+		if (quit) {
+			return;
+		}
+		work(pool, start.id);
+	}
+}
+
+// Frees whatever of the pool got allocated, once no workers are running
+static void freePoolParts(JobPool *pool) {
+	if (pool->done != NULL) {
+		freeCond(pool->done);
+	}
+	if (pool->wake != NULL) {
+		freeCond(pool->wake);
+	}
+	if (pool->lock != NULL) {
+		freeMutex(pool->lock);
+	}
+	free(pool->threads);
+	free(pool->workers);
+	free(pool);
+}
+
+JobPool *newJobPool(int workers) {
+	if (workers <= 0) {
+		workers = getCpuCount();
+	}
+	JobPool *pool = calloc(1, sizeof(JobPool));
+	if (pool == NULL) {
+		return NULL;
+	}
+	pool->size = workers;
+	pool->workers = calloc(workers, sizeof(Worker));
+	pool->threads = calloc(workers, sizeof(Thread));
+	pool->lock = newMutex();
+	pool->wake = newCond();
+	pool->done = newCond();
+	if (pool->workers == NULL || pool->threads == NULL || pool->lock == NULL
+		|| pool->wake == NULL || pool->done == NULL) {
+		freePoolParts(pool);
+		return NULL;
+	}
+
+	// Worker 0 is whoever calls runJobs
+	for (int i = 1; i < workers; ++i) {
+		WorkerStart *start = malloc(sizeof(WorkerStart));
+		if (start == NULL) {
+			// Stops the workers started so far
+			pool->size = i;
+			freeJobPool(pool);
+			return NULL;
+		}
+		*start = (WorkerStart){pool, i};
+		if (!startThread(&pool->threads[i], workerMain, start)) {
+			free(start);
+			pool->size = i;
+			break;
+		}
+	}
+	return pool;
+}
+
+void freeJobPool(JobPool *pool) {
+	if (pool == NULL) {
+		return;
+	}
+	lockMutex(pool->lock);
+	pool->quit = 1;
+	broadcastCond(pool->wake);
+	unlockMutex(pool->lock);
+	for (int i = 1; i < pool->size; ++i) {
+		joinThread(pool->threads[i]);
+	}
+	freePoolParts(pool);
+}
+
+int getJobPoolSize(const JobPool *pool) {
+	return pool->size;
+}
+
+void runJobs(JobPool *pool, int chunks, JobFn fn, void *ctx) {
+	if (chunks <= 0) {
+		return;
+	}
+	lockMutex(pool->lock);
+	pool->fn = fn;
+	pool->ctx = ctx;
+	atomicStore(&pool->remaining, chunks);
+	for (int i = 0; i < pool->size; ++i) {
+		int head = (int)((long long)chunks * i / pool->size);
+		int tail = (int)((long long)chunks * (i + 1) / pool->size);
+		atomicStore(&pool->workers[i].range, PACK(head, tail));
+	}
+	pool->generation++;
+	broadcastCond(pool->wake);
+	unlockMutex(pool->lock);
+
+	work(pool, 0);
+
+	lockMutex(pool->lock);
+	while (atomicLoad(&pool->remaining) > 0) {
+		waitCond(pool->done, pool->lock);
+	}
+	unlockMutex(pool->lock);
+}
@@ -0,0 +1,134 @@
+#include "include/lyapunov.h"
+
+#define ONE_SIXTH ((real)1 / 6)
+
+// Partial derivatives of the equations in doubleDerivative. With S and C the
+// sin and cos of t0 - t1, every acceleration is num / (l den), so
+// d(num / (l den)) = (d num - a l d den) / (l den).
+void doubleJacobian(const real y[4], const DoubleParams *params, real jacobian[16]) {
+	const DoubleParams *p = params;
+	evalReal s0 = evalSin(y[0]), c0 = evalCos(y[0]);
+	evalReal s1 = evalSin(y[2]), c1 = evalCos(y[2]);
+	evalReal S = s0 * c1 - c0 * s1;
+	evalReal C = c0 * c1 + s0 * s1;
+	evalReal w0 = y[1];
+	evalReal w1 = y[3];
+
+	evalReal m01 = p->m0 + p->m1;
+	evalReal den = p->m0 + p->m1 * S * S;
+	evalReal k0 = p->l0 * w0 * w0;
+	evalReal k1 = p->m1 * p->l1 * w1 * w1;
+	evalReal x = p->g * s1 - k0 * S;
+	evalReal z = k1 * S + m01 * p->g * s0;
+	evalReal a0 = (p->m1 * C * x - z) / (p->l0 * den);
+	evalReal a1 = (C * z - m01 * x) / (p->l1 * den);
+
+	// Columns are t0, w0, t1, w1
+	evalReal dC[4] = {-S, 0, S, 0};
+	evalReal dx[4] = {-k0 * C, -2 * p->l0 * w0 * S, p->g * c1 + k0 * C, 0};
+	evalReal dz[4] = {k1 * C + m01 * p->g * c0, 0, -k1 * C, 2 * p->m1 * p->l1 * w1 * S};
+	evalReal dDen[4] = {2 * p->m1 * S * C, 0, -2 * p->m1 * S * C, 0};
+
+	for (int j = 0; j < 4; ++j) {
+		evalReal dNum0 = p->m1 * (dC[j] * x + C * dx[j]) - dz[j];
+		evalReal dNum1 = dC[j] * z + C * dz[j] - m01 * dx[j];
+		jacobian[0 * 4 + j] = (j == 1);
+		jacobian[1 * 4 + j] = (dNum0 - a0 * p->l0 * dDen[j]) / (p->l0 * den);
+		jacobian[2 * 4 + j] = (j == 3);
+		jacobian[3 * 4 + j] = (dNum1 - a1 * p->l1 * dDen[j]) / (p->l1 * den);
+	}
+}
+
+void lyapunovDerivative(const real y[], real dydt[], const void *params) {
+	real jacobian[16];
+	doubleDerivative(y, dydt, params);
+	doubleJacobian(y, (const DoubleParams *)params, jacobian);
+	// dv/dt = J v for every tangent vector
+	for (int v = 1; v <= LYAPUNOV_DIM; ++v) {
+		const real *in = y + v * LYAPUNOV_DIM;
+		real *out = dydt + v * LYAPUNOV_DIM;
+		for (int i = 0; i < 4; ++i) {
+			const real *row = jacobian + i * 4;
+			out[i] = row[0] * in[0] + row[1] * in[1] + row[2] * in[2] + row[3] * in[3];
+		}
+	}
+}
+
+// Modified Gram-Schmidt over the tangent vectors, adding the log of each
+// length before it gets normalized away
+static void orthonormalize(Lyapunov *ly) {
+	for (int v = 0; v < LYAPUNOV_DIM; ++v) {
+		real *a = ly->y + (v + 1) * LYAPUNOV_DIM;
+		for (int u = 0; u < v; ++u) {
+			const real *b = ly->y + (u + 1) * LYAPUNOV_DIM;
+			real dot = 0;
+			for (int i = 0; i < LYAPUNOV_DIM; ++i) {
+				dot += a[i] * b[i];
+			}
+			for (int i = 0; i < LYAPUNOV_DIM; ++i) {
+				a[i] -= dot * b[i];
+			}
+		}
+		real norm = 0;
+		for (int i = 0; i < LYAPUNOV_DIM; ++i) {
+			norm += a[i] * a[i];
+		}
+		norm = realSqrt(norm);
+		ly->sum[v] += realLog(norm);
+		for (int i = 0; i < LYAPUNOV_DIM; ++i) {
+			a[i] /= norm;
+		}
+	}
+	ly->sumTime = ly->time;
+	ly->steps = 0;
+}
+
+void initLyapunov(Lyapunov *lyapunov, Body body0, Body body1, real g) {
+	*lyapunov = (Lyapunov){0};
+	lyapunov->params = getDoubleParams(body0, body1, g);
+	packDouble(body0, body1, lyapunov->y);
+	for (int v = 0; v < LYAPUNOV_DIM; ++v) {
+		lyapunov->y[(v + 1) * LYAPUNOV_DIM + v] = 1;
+	}
+}
+
+void stepLyapunov(Lyapunov *lyapunov, real dt) {
+	real *y = lyapunov->y;
+	real k1[LYAPUNOV_STATE], k2[LYAPUNOV_STATE], k3[LYAPUNOV_STATE], k4[LYAPUNOV_STATE];
+	real tmp[LYAPUNOV_STATE];
+	const void *params = &lyapunov->params;
+
+	lyapunovDerivative(y, k1, params);
+	for (int i = 0; i < LYAPUNOV_STATE; ++i) tmp[i] = y[i] + 0.5f * dt * k1[i];
+	lyapunovDerivative(tmp, k2, params);
+	for (int i = 0; i < LYAPUNOV_STATE; ++i) tmp[i] = y[i] + 0.5f * dt * k2[i];
+	lyapunovDerivative(tmp, k3, params);
+	for (int i = 0; i < LYAPUNOV_STATE; ++i) tmp[i] = y[i] + dt * k3[i];
+	lyapunovDerivative(tmp, k4, params);
+	for (int i = 0; i < LYAPUNOV_STATE; ++i) {
+		y[i] += ONE_SIXTH * dt * (k1[i] + 2*k2[i] + 2*k3[i] + k4[i]);
+	}
+
+	lyapunov->time += dt;
+	if (++lyapunov->steps >= LYAPUNOV_RENORM) {
+		orthonormalize(lyapunov);
+	}
+}
+
+void getLyapunovBodies(const Lyapunov *lyapunov, Body *body0, Body *body1) {
+	unpackDouble(lyapunov->y, body0, body1);
+}
+
+void getLyapunovSpectrum(const Lyapunov *lyapunov, real spectrum[LYAPUNOV_DIM]) {
+	for (int v = 0; v < LYAPUNOV_DIM; ++v) {
+		spectrum[v] = (lyapunov->sumTime > 0) ? lyapunov->sum[v] / lyapunov->sumTime : 0;
+	}
+	// Gram-Schmidt order is largest first on average but not every time
+	for (int i = 1; i < LYAPUNOV_DIM; ++i) {
+		for (int j = i; j > 0 && spectrum[j] > spectrum[j - 1]; --j) {
+			real tmp = spectrum[j];
+			spectrum[j] = spectrum[j - 1];
+			spectrum[j - 1] = tmp;
+		}
+	}
+}
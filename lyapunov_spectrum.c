@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/lyapunov.h"
+#include "include/jobs.h"
+
+// Headless Lyapunov spectra. Reads one double pendulum per line from stdin,
+//
+//   theta0 theta1 [omega0 omega1 [m0 m1 l0 l1]]
+//
+// runs them in parallel, and writes one CSV row per pendulum in input order.
+//
+//   lyapunov_spectrum [-t seconds] [-dt step] [-g gravity] [-j threads] < input
+
+#define GRAVITY 9.81f
+#define DURATION 200.0f
+#define PHYSICS_DT 0.001f
+#define INITIAL_CAPACITY 256
+
+typedef struct SpectrumJob {
+	Body (*bodies)[2];
+	real (*spectra)[LYAPUNOV_DIM];
+	real g;
+	real dt;
+	int steps;
+} SpectrumJob;
+
+static void spectrumChunk(void *ctx, int chunk, int worker) {
+	SpectrumJob *job = (SpectrumJob *)ctx;
+	Lyapunov lyapunov;
+	initLyapunov(&lyapunov, job->bodies[chunk][0], job->bodies[chunk][1], job->g);
+	for (int s = 0; s < job->steps; ++s) {
+		stepLyapunov(&lyapunov, job->dt);
+	}
+	getLyapunovSpectrum(&lyapunov, job->spectra[chunk]);
+}
+
+int main(int argc, char **argv) {
+	float duration = DURATION;
+	float dt = PHYSICS_DT;
+	float g = GRAVITY;
+	int threads = 0;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-t") == 0) {
+			duration = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-dt") == 0) {
+			dt = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-g") == 0) {
+			g = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			threads = atoi(argv[i + 1]);
+		} else {
+			break;
+		}
+	}
+	if (dt <= 0 || duration < dt) {
+		fprintf(stderr, "usage: lyapunov_spectrum [-t seconds] [-dt step] [-g gravity] [-j threads] < input\n");
+		return 1;
+	}
+
+	int count = 0, capacity = INITIAL_CAPACITY;
+	Body (*bodies)[2] = malloc(capacity * sizeof(*bodies));
+	char line[512];
+	while (bodies != NULL && fgets(line, sizeof(line), stdin) != NULL) {
+		double v[8] = {0, 0, 0, 0, 1, 1, 1, 1};
+		int read = sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf",
+			&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+		if (read < 2) {
+			continue; // blank lines and comments
+		}
+		if (count == capacity) {
+			capacity *= 2;
+			void *grown = realloc(bodies, capacity * sizeof(*bodies));
+			if (grown == NULL) {
+				free(bodies);
+				bodies = NULL;
+				break;
+			}
+			bodies = grown;
+		}
+		bodies[count][0] = (Body){(real)v[4], (real)v[6], (real)v[0], (real)v[2]};
+		bodies[count][1] = (Body){(real)v[5], (real)v[7], (real)v[1], (real)v[3]};
+		++count;
+	}
+	real (*spectra)[LYAPUNOV_DIM] = malloc((count > 0 ? count : 1) * sizeof(*spectra));
+	JobPool *pool = newJobPool(threads);
+	if (bodies == NULL || spectra == NULL || pool == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	// One pendulum per chunk, they all take about as long
+	SpectrumJob job = {bodies, spectra, g, dt, (int)(duration / dt)};
+	runJobs(pool, count, spectrumChunk, &job);
+
+	printf("theta0,theta1,omega0,omega1,lambda0,lambda1,lambda2,lambda3\n");
+	for (int i = 0; i < count; ++i) {
+		printf("%g,%g,%g,%g,%g,%g,%g,%g\n", (double)bodies[i][0].theta, (double)bodies[i][1].theta,
+			(double)bodies[i][0].omega, (double)bodies[i][1].omega, (double)spectra[i][0],
+			(double)spectra[i][1], (double)spectra[i][2], (double)spectra[i][3]);
+	}
+
+	freeJobPool(pool);
+	free(spectra);
+	free(bodies);
+	return 0;
+}
@@ -1,83 +1,169 @@
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include "include/raylib.h"
 #include "include/raymath.h"
-
-#define GRAVITY (-9.8f)
-#define BODY_COUNT 4
+#include "include/pendulum.h"
+#include "include/simthread.h"
+#include "include/trajectory.h"
+#include "include/trace.h"
+#include "include/export.h"
+#include "include/scenario.h"
+
+#define SCENARIO_PATH "scenarios/nbody.scn" // the chain, gravity and integrator, -scenario picks another
 #define RADIUS 16
+#define RECORD_PATH "nbody_pendulum.traj"
+#define TRACE_PATH "nbody_pendulum.trace.json" // T starts and stops a trace
+#define EXPORT_FPS 60 // -export, -raw or -pipe renders frames without a window, see include/export.h
+#define EXPORT_SECONDS 10.0f
 
-typedef struct Body {
-	float mass;
-	float length;
-	float theta;
-} Body;
-
-void render(Body bodies[], Vector2 origin);
-void solve(Body bodies[], float dt);
+void render(Body bodies[], int count, Vector2 origin);
 Vector2 getPos(Body body);
 
-int main(void) {
+int main(int argc, char **argv) {
 	const Vector2 screenSize = {1280, 720};
 	const char *screenName = "N-Body Pendulum";
 	const int targetFPS = 60;
 
+	const char *scenarioPath = SCENARIO_PATH;
+	if (argc >= 3 && strcmp(argv[1], "-scenario") == 0) {
+		scenarioPath = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+	Scenario scenario;
+	if (!loadScenario(scenarioPath, &scenario)) {
+		return 1;
+	}
+	const int count = scenario.count;
+	const real g = scenario.g;
+	const float dt = scenario.dt;
+	const Integrator integrator = scenario.integrator;
+
+	Body bodies[SIM_MAX_BODIES];
+	for (int i = 0; i < count; ++i) {
+		bodies[i] = scenario.bodies[i];
+	}
+
+	float radius[SIM_MAX_BODIES];
+	for (int i = 0; i < count; ++i) {
+		radius[i] = RADIUS;
+	}
+	ExportOptions export = {
+		.width = screenSize.x,
+		.height = screenSize.y,
+		.fps = EXPORT_FPS,
+		.duration = EXPORT_SECONDS,
+		.bodies = bodies,
+		.count = count,
+		.g = g,
+		.dt = dt,
+		.integrator = integrator,
+		.pivotRadius = RADIUS / 2.0f,
+		.radius = radius,
+	};
+	int exporting = parseExportArgs(argc, argv, &export);
+	if (exporting != 0) {
+		export.originX = export.width / 2.0f;
+		export.originY = export.height / 4.0f;
+		export.scale = export.height / screenSize.y;
+		return exporting < 0 || runExport(&export) < 0;
+	}
+
 	InitWindow(screenSize.x, screenSize.y, screenName);
 	SetTargetFPS(targetFPS);
 
 	Vector2 origin = (Vector2){screenSize.x / 2, screenSize.y / 4};
 
-	Body bodies[BODY_COUNT];
-	bodies[0] = (Body){ 1.0f, 100, PI/5 };
-	bodies[1] = (Body){ 2.0f, 150, PI/5 };
-	bodies[2] = (Body){ 3.0f, 50, PI/5 };
-	bodies[3] = (Body){ 4.0f, 100, PI/5 };
+	Body drawBodies[SIM_MAX_BODIES];
 
-	while (!WindowShouldClose()) {
-		float dt = GetFrameTime();
-		solve(bodies, dt);
-		render(bodies, origin);
+	// Steps on its own thread at its own rate, so vsync doesn't hold it back
+	SimThread *sim = startSimThread(bodies, count, g, dt, integrator);
+	if (sim == NULL) {
+		CloseWindow();
+		return 1;
 	}
+	setSimRunning(sim, 1);
 
-	CloseWindow();
+	Recorder *recorder = NULL;
+	real initialEnergy = getSystemEnergy(bodies, count, g);
+	setTraceThreadName("main");
 
-	return 0;
-}
-
-void render(Body bodies[], Vector2 origin) {
-	BeginDrawing();
-
-	ClearBackground(BLACK);
-
-	{
-		// Draw arms
-		Vector2 prevPos = origin;
-		for (int i = 0; i < BODY_COUNT; ++i) {
-			Vector2 newPos = Vector2Add(prevPos, getPos(bodies[i]));
-			DrawLineV(prevPos, newPos, WHITE);
-			prevPos = newPos;
+	while (!WindowShouldClose()) {
+		TRACE_BEGIN("frame");
+		if (IsKeyPressed(KEY_T)) {
+			if (!traceEnabled) {
+				startTrace();
+			} else {
+				stopTrace(TRACE_PATH);
+			}
+		}
+		if (IsKeyPressed(KEY_R)) {
+			if (recorder == NULL) {
+				recorder = startRecorder(RECORD_PATH, bodies, count, g, dt, integrator);
+				setSimRecorder(sim, recorder);
+			} else {
+				stopRecorder(setSimRecorder(sim, NULL));
+				recorder = NULL;
+			}
 		}
 
-		// Draw bodies
-		prevPos = origin;
-		DrawCircleV(origin, RADIUS / 2.0f, RED);
-		for (int i = 0; i < BODY_COUNT; ++i) {
-			Vector2 newPos = Vector2Add(prevPos, getPos(bodies[i]));
-			DrawCircleV(newPos, RADIUS, BLUE);
-			prevPos = newPos;
+		// Only picks up the latest state, the stepping happens on the physics thread
+		TRACE_BEGIN("physics");
+		const SimFrame *frame = readSimFrame(sim);
+		for (int j = 0; j < count; ++j) {
+			bodies[j] = frame->bodies[j];
+			drawBodies[j] = interpolateBody(frame->prev[j], frame->bodies[j], frame->alpha);
+		}
+		TRACE_END("physics");
+		TRACE_COUNTER("energy drift %",
+			100.0 * (getSystemEnergy(bodies, count, g) - initialEnergy) / initialEnergy);
+
+		BeginDrawing();
+		TRACE_BEGIN("render");
+		ClearBackground(BLACK);
+		render(drawBodies, count, origin);
+		TRACE_END("render");
+		TRACE_BEGIN("ui");
+		if (recorder != NULL) {
+			DrawText(TextFormat("Recording: %lld frames, %lld dropped (R)", getRecorderFrames(recorder),
+				getRecorderDropped(recorder)), 20, 20, 24, RED);
 		}
+		if (traceEnabled) {
+			DrawText("Tracing (T)", 20, 50, 24, RED);
+		}
+		TRACE_END("ui");
+		EndDrawing();
+		TRACE_END("frame");
+	}
+
+	if (traceEnabled) {
+		stopTrace(TRACE_PATH);
 	}
+	stopSimThread(sim);
+	stopRecorder(recorder);
+	CloseWindow();
 
-	EndDrawing();
+	return 0;
 }
 
-void solve(Body bodies[], float dt) {
-	float omega = PI / 4;
-	for (int i = 0; i < BODY_COUNT; ++i) {
-		bodies[i].theta += omega * cosf(omega * GetTime()) * dt * bodies[i].mass;
+void render(Body bodies[], int count, Vector2 origin) {
+	// Draw arms
+	Vector2 prevPos = origin;
+	for (int i = 0; i < count; ++i) {
+		Vector2 newPos = Vector2Add(prevPos, getPos(bodies[i]));
+		DrawLineV(prevPos, newPos, WHITE);
+		prevPos = newPos;
 	}
 
-	return;
+	// Draw bodies
+	prevPos = origin;
+	DrawCircleV(origin, RADIUS / 2.0f, RED);
+	for (int i = 0; i < count; ++i) {
+		Vector2 newPos = Vector2Add(prevPos, getPos(bodies[i]));
+		DrawCircleV(newPos, RADIUS, BLUE);
+		prevPos = newPos;
+	}
 }
 
 Vector2 getPos(Body body) {
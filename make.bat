@@ -1,19 +1,43 @@
 @echo off
 set program=%1
+rem Optional second argument picks the precision, double or mixed (see include\real.h)
+set defines=
+if "%2"=="double" set defines=/DPENDULUM_DOUBLE
+if "%2"=="mixed" set defines=/DPENDULUM_MIXED
+rem set PROFILE=1 first to compile in the frame profiler (F3 in the viewer)
+if "%PROFILE%"=="1" set defines=%defines% /DPENDULUM_PROFILE
+set libsrc=..\pendulum.c ..\fixedstep.c ..\dopri.c ..\symplectic.c ..\ensemble.c ..\ensemble_sse.c ..\ensemble_avx2.c ..\ensemble_avx512.c ..\thread.c ..\jobs.c ..\runner.c ..\recorder.c ..\replay.c ..\flipmap.c ..\lyapunov.c ..\poincare.c ..\profiler.c ..\trace.c ..\simthread.c ..\export.c ..\scenario.c ..\sweep.c
+set libobj=pendulum.obj fixedstep.obj dopri.obj symplectic.obj ensemble.obj ensemble_sse.obj ensemble_avx2.obj ensemble_avx512.obj thread.obj jobs.obj runner.obj recorder.obj replay.obj flipmap.obj lyapunov.obj poincare.obj profiler.obj trace.obj simthread.obj export.obj scenario.obj sweep.obj
 
 mkdir build
 pushd build
 
 if "%program%"=="nbody" (
-	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\main.c ..\ui.c /I \include /Zi /link /out:N_Body_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\main.c ..\ui.c %libsrc% %defines% /I \include /Zi /link /out:N_Body_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
 ) else if "%program%"=="single" (
-	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\single_pendulum.c ..\ui.c /I \include /Zi /link /out:Single_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\single_pendulum.c ..\ui.c %libsrc% %defines% /I \include /Zi /link /out:Single_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
 ) else if "%program%"=="double" (
-	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\double_pendulum.c ..\ui.c /I \include /Zi /link /out:Double_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\double_pendulum.c ..\ui.c ..\ensemble_view.c %libsrc% %defines% /I \include /Zi /link /out:Double_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
 ) else if "%program%"=="all" (
-	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\main.c ..\ui.c /I \include /Zi /link /out:N_Body_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
-	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\single_pendulum.c ..\ui.c /I \include /Zi /link /out:Single_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
-	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\double_pendulum.c ..\ui.c /I \include /Zi /link /out:Double_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\main.c ..\ui.c %libsrc% %defines% /I \include /Zi /link /out:N_Body_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\single_pendulum.c ..\ui.c %libsrc% %defines% /I \include /Zi /link /out:Single_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\double_pendulum.c ..\ui.c ..\ensemble_view.c %libsrc% %defines% /I \include /Zi /link /out:Double_Pendulum.exe /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup /MACHINE:X64 ..\lib\raylib.lib msvcrt.lib opengl32.lib kernel32.lib user32.lib gdi32.lib winmm.lib shell32.lib /NODEFAULTLIB:libcmt
+) else if "%program%"=="flipmap" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\flip_map.c %libsrc% %defines% /O2 /Fe:Flip_Map.exe
+) else if "%program%"=="lyapunov" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\lyapunov_spectrum.c %libsrc% %defines% /O2 /Fe:Lyapunov_Spectrum.exe
+) else if "%program%"=="poincare" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\poincare_section.c %libsrc% %defines% /O2 /Fe:Poincare_Section.exe
+) else if "%program%"=="bench" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\bench.c %libsrc% %defines% /O2 /Fe:Bench.exe
+) else if "%program%"=="export" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\export_frames.c %libsrc% %defines% /O2 /Fe:Export_Frames.exe
+) else if "%program%"=="sweep" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\param_sweep.c %libsrc% %defines% /O2 /Fe:Param_Sweep.exe
+) else if "%program%"=="check" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl ..\check.c %libsrc% %defines% /O2 /Fe:Check.exe && Check.exe .
+) else if "%program%"=="lib" (
+	call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" && cl /c %libsrc% %defines% /O2 && lib %libobj% /out:pendulum.lib
 ) else (
 	echo "wrong usage"
 )
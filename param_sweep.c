@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/sweep.h"
+
+// Headless parameter sweep of the double pendulum, see sweep.h. Takes the
+// starting state and the ranges from a scenario (scenario.h):
+//
+//   - with -lhs, that many Latin hypercube samples of its vary ranges
+//   - otherwise its runs table, if it has one
+//   - otherwise every combination of its vary axes
+//
+// and writes one CSV row per run, in order: the run's number, the values it
+// was given, then its metrics.
+//
+//   param_sweep [-scenario sweep.scn] [-lhs samples] [-seed n] [-t seconds] [-j threads] [-o out.csv]
+
+#define SCENARIO_PATH "scenarios/sweep.scn"
+#define DURATION 20.0f
+#define SEED 1
+#define USAGE "usage: param_sweep [-scenario sweep.scn] [-lhs samples] [-seed n] [-t seconds] [-j threads] [-o out.csv]\n"
+
+typedef enum Source {
+	CARTESIAN,
+	LATIN_HYPERCUBE,
+	TABLE
+} Source;
+
+int main(int argc, char **argv) {
+	const char *scenarioPath = SCENARIO_PATH;
+	const char *output = NULL;
+	float duration = DURATION;
+	int samples = 0;
+	unsigned long long seed = SEED;
+	int threads = 0;
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 >= argc) {
+			fprintf(stderr, "%s needs a value\n" USAGE, argv[i]);
+			return 1;
+		}
+		if (strcmp(argv[i], "-scenario") == 0) {
+			scenarioPath = argv[i + 1];
+		} else if (strcmp(argv[i], "-lhs") == 0) {
+			samples = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[i + 1], NULL, 10);
+		} else if (strcmp(argv[i], "-t") == 0) {
+			duration = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			threads = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "-o") == 0) {
+			output = argv[i + 1];
+		} else {
+			fprintf(stderr, "unknown option %s\n" USAGE, argv[i]);
+			return 1;
+		}
+	}
+
+	Scenario scenario;
+	ScenarioFile *file = openScenario(scenarioPath, &scenario);
+	if (file == NULL) {
+		return 1;
+	}
+	Source source = samples > 0 ? LATIN_HYPERCUBE : scenario.columnCount > 0 ? TABLE : CARTESIAN;
+	int paramCount = source == TABLE ? scenario.columnCount : scenario.axisCount;
+	if (scenario.count != 2 || paramCount == 0 || duration < scenario.dt) {
+		fprintf(stderr, "%s needs two bodies and vary lines or a runs table\n", scenarioPath);
+		fprintf(stderr, USAGE);
+		return 1;
+	}
+	ScenarioParam params[SCENARIO_MAX_COLUMNS];
+	for (int p = 0; p < paramCount; ++p) {
+		params[p] = source == TABLE ? scenario.columns[p] : scenario.axes[p].param;
+	}
+	long long total = source == LATIN_HYPERCUBE ? samples
+					: source == CARTESIAN ? getCartesianCount(scenario.axes, scenario.axisCount) : -1;
+	if (source == CARTESIAN && total < 0) {
+		fprintf(stderr, "too many combinations\n");
+		return 1;
+	}
+
+	LatinHypercube lhs = {0};
+	real *values = malloc((size_t)SWEEP_BATCH * paramCount * sizeof(real));
+	SweepMetrics *metrics = malloc(SWEEP_BATCH * sizeof(SweepMetrics));
+	JobPool *pool = newJobPool(threads);
+	if (values == NULL || metrics == NULL || pool == NULL || (source == LATIN_HYPERCUBE &&
+		!newLatinHypercube(&lhs, scenario.axes, scenario.axisCount, samples, seed))) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	FILE *out = output != NULL ? fopen(output, "w") : stdout;
+	if (out == NULL) {
+		fprintf(stderr, "couldn't write %s\n", output);
+		return 1;
+	}
+
+	fprintf(out, "run");
+	for (int p = 0; p < paramCount; ++p) {
+		char name[16];
+		getScenarioParamName(params[p], name);
+		fprintf(out, ",%s", name);
+	}
+	fprintf(out, ",max_drift,flips,first_flip,lyapunov\n");
+
+	Sweep sweep = {
+		.body0 = scenario.bodies[0],
+		.body1 = scenario.bodies[1],
+		.g = scenario.g,
+		.dt = scenario.dt,
+		.integrator = scenario.integrator,
+		.duration = duration,
+		.params = params,
+		.paramCount = paramCount,
+		.values = values,
+		.metrics = metrics,
+	};
+	fprintf(stderr, "%s, %g s per run at dt %g (%s) on %d threads\n",
+		source == LATIN_HYPERCUBE ? "Latin hypercube" : source == TABLE ? "runs table" : "grid",
+		duration, scenario.dt, getIntegratorName(scenario.integrator), getJobPoolSize(pool));
+
+	double start = getClock();
+	long long done = 0;
+	int failed = 0;
+	while (!failed && (total < 0 || done < total)) {
+		// Fill a batch from wherever the runs come from, then measure it all at once
+		int count = 0;
+		for (; count < SWEEP_BATCH && (total < 0 || done + count < total); ++count) {
+			real *run = values + (size_t)count * paramCount;
+			if (source == CARTESIAN) {
+				getCartesianRun(scenario.axes, scenario.axisCount, done + count, run);
+			} else if (source == LATIN_HYPERCUBE) {
+				getLatinHypercubeRun(&lhs, done + count, run);
+			} else {
+				int read = readScenarioRun(file, run);
+				failed = read < 0;
+				if (read <= 0) {
+					total = done + count;
+					break;
+				}
+			}
+		}
+		sweep.count = count;
+		runSweep(pool, &sweep);
+
+		for (int r = 0; r < count; ++r) {
+			fprintf(out, "%lld", done + r);
+			for (int p = 0; p < paramCount; ++p) {
+				fprintf(out, ",%g", (double)values[(size_t)r * paramCount + p]);
+			}
+			fprintf(out, ",%g,%d,%g,%g\n", (double)metrics[r].maxDrift, metrics[r].flips,
+				(double)metrics[r].firstFlip, (double)metrics[r].lyapunov);
+		}
+		done += count;
+		double elapsed = getClock() - start;
+		if (total > 0) {
+			fprintf(stderr, "\r%lld/%lld runs, %.0f per second, %.0f s left ", done, total,
+				done / elapsed, (total - done) * elapsed / done);
+		} else {
+			fprintf(stderr, "\r%lld runs, %.0f per second ", done, done / elapsed);
+		}
+	}
+	fprintf(stderr, "\n%lld runs in %.1f s\n", done, getClock() - start);
+
+	if (output != NULL && fclose(out) != 0) {
+		fprintf(stderr, "couldn't write %s\n", output);
+		failed = 1;
+	}
+	closeScenario(file);
+	freeLatinHypercube(&lhs);
+	freeJobPool(pool);
+	free(values);
+	free(metrics);
+	return failed;
+}
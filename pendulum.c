@@ -0,0 +1,426 @@
+#include "include/pendulum.h"
+#include "include/dopri.h"
+#include "include/symplectic.h"
+
+#define ONE_SIXTH ((real)1 / 6)
+
+const char *getIntegratorName(Integrator integrator) {
+	switch (integrator) {
+		case EULER: return "Euler";
+		case RK4: return "RK4";
+		case RK45: return "RK45";
+		case VERLET: return "Verlet";
+		case YOSHIDA4: return "Yoshida 4";
+		case YOSHIDA6: return "Yoshida 6";
+		default: return "?";
+	}
+}
+
+Body interpolateBody(Body prev, Body curr, real alpha) {
+	curr.theta = prev.theta + alpha * (curr.theta - prev.theta);
+	curr.omega = prev.omega + alpha * (curr.omega - prev.omega);
+	return curr;
+}
+
+real singleAlpha(Body body, real g) {
+	return - (g / body.length) * evalSin(body.theta);
+}
+
+void solveSingle(Body *body, real g, real dt, Integrator integrator) {
+	switch (integrator) {
+		case EULER: {
+			body->theta += dt * body->omega;
+			body->omega += dt * singleAlpha(*body, g);
+		} break;
+		case RK45: {
+			SingleParams params = (SingleParams){body->length, g};
+			real y[2] = {body->theta, body->omega};
+			Dopri rk;
+			initDopri(&rk, singleDerivative, &params, y, 2, DOUBLE_TOL, dt);
+			rk.hMax = dt;
+			if (advanceDopri(&rk, dt)) {
+				denseDopri(&rk, dt, y);
+			} else {
+				y[0] = y[1] = (real)NAN; // gave up, show it rather than stopping short
+			}
+			body->theta = y[0];
+			body->omega = y[1];
+		} break;
+		case VERLET: verletSingle(body, g, dt); break;
+		case YOSHIDA4: yoshidaSingle(body, g, dt, 4); break;
+		case YOSHIDA6: yoshidaSingle(body, g, dt, 6); break;
+		default: {
+			Body b = *body;
+			real omegaDot1 = singleAlpha(b, g);
+			real thetaDot1 = body->omega;
+			b.theta = body->theta + 0.5f * dt * thetaDot1;
+			real omegaDot2 = singleAlpha(b, g);
+			real thetaDot2 = body->omega + 0.5f * dt * omegaDot1;
+			b.theta = body->theta + 0.5f * dt * thetaDot2;
+			real omegaDot3 = singleAlpha(b, g);
+			real thetaDot3 = body->omega + 0.5f * dt * omegaDot2;
+			b.theta = body->theta + dt * thetaDot3;
+			real omegaDot4 = singleAlpha(b, g);
+			real thetaDot4 = body->omega + dt * omegaDot3;
+
+			body->omega += ONE_SIXTH * dt * (omegaDot1 + 2*omegaDot2 + 2*omegaDot3 + omegaDot4);
+			body->theta += ONE_SIXTH * dt * (thetaDot1 + 2*thetaDot2 + 2*thetaDot3 + thetaDot4);
+		} break;
+	}
+}
+
+void singleDerivative(const real y[], real dydt[], const void *params) {
+	const SingleParams *p = (const SingleParams *)params;
+	dydt[0] = y[1];
+	dydt[1] = - (p->g / p->length) * evalSin(y[0]);
+}
+
+real getSingleEnergy(Body body, real g) {
+	// E = 0.5mv^2 + mgh
+	real kinetic = 0.5f * body.mass * body.length * body.length * body.omega * body.omega;
+	real potential = body.mass * g * body.length * (1 - realCos(body.theta));
+	return kinetic + potential;
+}
+
+real omegadot0(Body body0, Body body1, real g) {
+	// This formula is so long, that this makes sense
+	evalReal m0 = body0.mass;
+	evalReal m1 = body1.mass;
+	evalReal l0 = body0.length;
+	evalReal l1 = body1.length;
+	evalReal t0 = body0.theta;
+	evalReal t1 = body1.theta;
+	evalReal w0 = body0.omega;
+	evalReal w1 = body1.omega;
+
+	return (m1 * evalCos(t0 - t1) * (l0 * w0 * w0 * evalSin(t1 - t0) + g * evalSin(t1))
+		- (m1 * l1 * w1 * w1 * evalSin(t0 - t1) + (m0 + m1) * g * evalSin(t0)))
+		/ (l0 * (m0 + m1 * evalSin(t0 - t1) * evalSin(t0-t1)));
+}
+
+real thetadot0(Body body0, Body body1) {
+	return body0.omega;
+}
+
+real omegadot1(Body body0, Body body1, real g) {
+	// This formula is so long, that this makes sense
+	evalReal m0 = body0.mass;
+	evalReal m1 = body1.mass;
+	evalReal l0 = body0.length;
+	evalReal l1 = body1.length;
+	evalReal t0 = body0.theta;
+	evalReal t1 = body1.theta;
+	evalReal w0 = body0.omega;
+	evalReal w1 = body1.omega;
+
+	return (evalCos(t0 - t1) * (m1 * l1 * w1 * w1 * evalSin(t0 - t1) + (m0 + m1) * g * evalSin(t0))
+		- (m0 + m1) * (l0 * w0 * w0 * evalSin(t1 - t0) + g * evalSin(t1)))
+		/ (l1 * (m0 + m1 * evalSin(t0 - t1) * evalSin(t0-t1)));
+}
+
+real thetadot1(Body body0, Body body1) {
+	return body1.omega;
+}
+
+void solveDouble(Body *body0, Body *body1, real g, real dt, Integrator integrator) {
+	if (integrator == RK45) {
+		// Adaptive substeps over dt. Anything calling this every frame should
+		// keep its own Dopri around instead so the step size carries over.
+		DoubleParams params = getDoubleParams(*body0, *body1, g);
+		real y[4];
+		Dopri rk;
+		packDouble(*body0, *body1, y);
+		initDopri(&rk, doubleDerivative, &params, y, 4, DOUBLE_TOL, dt);
+		rk.hMax = dt;
+		if (advanceDopri(&rk, dt)) {
+			denseDopri(&rk, dt, y);
+		} else {
+			y[0] = y[1] = y[2] = y[3] = (real)NAN; // gave up, show it rather than stopping short
+		}
+		unpackDouble(y, body0, body1);
+		return;
+	}
+	if (integrator == VERLET) {
+		verletDouble(body0, body1, g, dt);
+		return;
+	}
+	if (integrator == YOSHIDA4 || integrator == YOSHIDA6) {
+		yoshidaDouble(body0, body1, g, dt, integrator == YOSHIDA4 ? 4 : 6);
+		return;
+	}
+	DoubleParams params = getDoubleParams(*body0, *body1, g);
+	real y[4], k1[4], k2[4], k3[4], k4[4], tmp[4];
+	packDouble(*body0, *body1, y);
+
+	if (integrator == EULER) {
+		doubleDerivative(y, k1, &params);
+		for (int i = 0; i < 4; ++i) {
+			y[i] += dt * k1[i];
+		}
+		unpackDouble(y, body0, body1);
+		return;
+	}
+
+	doubleDerivative(y, k1, &params);
+	for (int i = 0; i < 4; ++i) tmp[i] = y[i] + 0.5f * dt * k1[i];
+	doubleDerivative(tmp, k2, &params);
+	for (int i = 0; i < 4; ++i) tmp[i] = y[i] + 0.5f * dt * k2[i];
+	doubleDerivative(tmp, k3, &params);
+	for (int i = 0; i < 4; ++i) tmp[i] = y[i] + dt * k3[i];
+	doubleDerivative(tmp, k4, &params);
+	for (int i = 0; i < 4; ++i) {
+		y[i] += ONE_SIXTH * dt * (k1[i] + 2*k2[i] + 2*k3[i] + k4[i]);
+	}
+	unpackDouble(y, body0, body1);
+}
+
+real getDoubleEnergy(Body body0, Body body1, real g) {
+	// E = 0.5mv^2 + mgh
+	// This formula is so long, that this makes sense
+	real m0 = body0.mass;
+	real m1 = body1.mass;
+	real l0 = body0.length;
+	real l1 = body1.length;
+	real t0 = body0.theta;
+	real t1 = body1.theta;
+	real w0 = body0.omega;
+	real w1 = body1.omega;
+
+	real kinetic = 0.5f * (m0 + m1) * l0 * l0 * w0 * w0
+		+ 0.5f * m1 * l1 * l1 * w1 * w1
+		+ m1 * l0 * l1 * w0 * w1 * realCos(t0 - t1);
+	real potential = (m0 + m1) * g * l0 * (1 - realCos(t0))
+		+ m1 * g * l1 * (1 - realCos(t1));
+	return kinetic + potential;
+}
+
+DoubleParams getDoubleParams(Body body0, Body body1, real g) {
+	return (DoubleParams){body0.mass, body1.mass, body0.length, body1.length, g};
+}
+
+void packDouble(Body body0, Body body1, real y[4]) {
+	y[0] = body0.theta;
+	y[1] = body0.omega;
+	y[2] = body1.theta;
+	y[3] = body1.omega;
+}
+
+void unpackDouble(const real y[4], Body *body0, Body *body1) {
+	body0->theta = y[0];
+	body0->omega = y[1];
+	body1->theta = y[2];
+	body1->omega = y[3];
+}
+
+// Same equations as omegadot0 and omegadot1, but sharing all the trig.
+// Only sin/cos of t0 and t1 are evaluated (the compiler turns each pair into
+// one sincos call), t0 - t1 comes from the angle difference identities.
+void doubleDerivative(const real y[], real dydt[], const void *params) {
+	const DoubleParams *p = (const DoubleParams *)params;
+	evalReal s0 = evalSin(y[0]), c0 = evalCos(y[0]);
+	evalReal s1 = evalSin(y[2]), c1 = evalCos(y[2]);
+	evalReal s01 = s0 * c1 - c0 * s1; // sin(t0 - t1)
+	evalReal c01 = c0 * c1 + s0 * s1; // cos(t0 - t1)
+	evalReal w0 = y[1];
+	evalReal w1 = y[3];
+
+	evalReal m01 = p->m0 + p->m1;
+	evalReal den = p->m0 + p->m1 * s01 * s01;
+	evalReal x = p->g * s1 - p->l0 * w0 * w0 * s01; // l0 w0^2 sin(t1 - t0) + g sin(t1)
+	evalReal z = p->m1 * p->l1 * w1 * w1 * s01 + m01 * p->g * s0;
+
+	dydt[0] = w0;
+	dydt[1] = (p->m1 * c01 * x - z) / (p->l0 * den);
+	dydt[2] = w1;
+	dydt[3] = (c01 * z - m01 * x) / (p->l1 * den);
+}
+
+// Angular accelerations of a chain of point masses on massless rods.
+//
+// Each rod can only push or pull along itself, so the unknowns are the rod
+// tensions T_i. Requiring that every rod keeps its length gives one equation
+// per rod that only involves T_{i-1}, T_i and T_{i+1}:
+//
+//   -c_{i-1,i}/m_{i-1} T_{i-1} + (1/m_i + 1/m_{i-1}) T_i - c_{i,i+1}/m_i T_{i+1}
+//       = l_i w_i^2 (+ g cos(t_0) for the top rod)
+//
+// where c_{i,j} = cos(t_i - t_j). That system is tridiagonal, so it is solved
+// with one sweep down the chain and one sweep back up. The tangential part of
+// the rod forces then gives each alpha_i directly, so the whole thing is O(N)
+// instead of building and solving the dense N x N mass matrix.
+int chainAlpha(const Body bodies[], int count, real g, real alpha[]) {
+	if (count < 1 || count > MAX_CHAIN) {
+		return 0;
+	}
+	evalReal s[MAX_CHAIN], c[MAX_CHAIN]; // sin/cos of each absolute angle
+	evalReal cUp[MAX_CHAIN], sUp[MAX_CHAIN]; // cos/sin(t_i - t_{i-1})
+	evalReal upper[MAX_CHAIN], rhs[MAX_CHAIN], tension[MAX_CHAIN];
+
+	for (int i = 0; i < count; ++i) {
+		s[i] = evalSin(bodies[i].theta);
+		c[i] = evalCos(bodies[i].theta);
+		if (i > 0) {
+			cUp[i] = c[i] * c[i - 1] + s[i] * s[i - 1];
+			sUp[i] = s[i] * c[i - 1] - c[i] * s[i - 1];
+		}
+	}
+
+	// Forward sweep: eliminate T_{i-1} from each row
+	for (int i = 0; i < count; ++i) {
+		evalReal invMass = 1.0f / bodies[i].mass;
+		evalReal diag = invMass;
+		evalReal r = bodies[i].length * bodies[i].omega * bodies[i].omega;
+		if (i == 0) {
+			r += g * c[0];
+		} else {
+			evalReal invMassUp = 1.0f / bodies[i - 1].mass;
+			evalReal lower = -cUp[i] * invMassUp;
+			diag += invMassUp;
+			diag -= lower * upper[i - 1];
+			r -= lower * rhs[i - 1];
+		}
+		upper[i] = (i + 1 < count) ? -cUp[i + 1] * invMass / diag : 0.0f;
+		rhs[i] = r / diag;
+	}
+
+	// Backward sweep: recover the tensions from the bottom up
+	for (int i = count - 1; i >= 0; --i) {
+		tension[i] = rhs[i] - ((i + 1 < count) ? upper[i] * tension[i + 1] : 0.0f);
+	}
+
+	// Tangential acceleration of each bob relative to the one above it
+	for (int i = 0; i < count; ++i) {
+		evalReal a = 0.0f;
+		if (i + 1 < count) {
+			a += tension[i + 1] * sUp[i + 1] / bodies[i].mass;
+		}
+		if (i == 0) {
+			a -= g * s[0];
+		} else {
+			a -= tension[i - 1] * sUp[i] / bodies[i - 1].mass;
+		}
+		alpha[i] = a / bodies[i].length;
+	}
+	return 1;
+}
+
+int solveChain(Body bodies[], int count, real g, real dt, Integrator integrator) {
+	if (count < 1 || count > MAX_CHAIN) {
+		return 0;
+	}
+	if (integrator == EULER) {
+		real alpha[MAX_CHAIN];
+		chainAlpha(bodies, count, g, alpha);
+		for (int i = 0; i < count; ++i) {
+			bodies[i].theta += dt * bodies[i].omega;
+			bodies[i].omega += dt * alpha[i];
+		}
+		return 1;
+	}
+
+	// RK4 over the whole chain; each stage is one O(N) call to chainAlpha
+	Body stage[MAX_CHAIN];
+	real k1w[MAX_CHAIN], k2w[MAX_CHAIN], k3w[MAX_CHAIN], k4w[MAX_CHAIN];
+	real k1t[MAX_CHAIN], k2t[MAX_CHAIN], k3t[MAX_CHAIN], k4t[MAX_CHAIN];
+
+	chainAlpha(bodies, count, g, k1w);
+	for (int i = 0; i < count; ++i) {
+		k1t[i] = bodies[i].omega;
+		stage[i] = bodies[i];
+		stage[i].theta += 0.5f * dt * k1t[i];
+		stage[i].omega += 0.5f * dt * k1w[i];
+	}
+
+	chainAlpha(stage, count, g, k2w);
+	for (int i = 0; i < count; ++i) {
+		k2t[i] = stage[i].omega;
+		stage[i].theta = bodies[i].theta + 0.5f * dt * k2t[i];
+		stage[i].omega = bodies[i].omega + 0.5f * dt * k2w[i];
+	}
+
+	chainAlpha(stage, count, g, k3w);
+	for (int i = 0; i < count; ++i) {
+		k3t[i] = stage[i].omega;
+		stage[i].theta = bodies[i].theta + dt * k3t[i];
+		stage[i].omega = bodies[i].omega + dt * k3w[i];
+	}
+
+	chainAlpha(stage, count, g, k4w);
+	for (int i = 0; i < count; ++i) {
+		k4t[i] = stage[i].omega;
+		bodies[i].theta += ONE_SIXTH * dt * (k1t[i] + 2*k2t[i] + 2*k3t[i] + k4t[i]);
+		bodies[i].omega += ONE_SIXTH * dt * (k1w[i] + 2*k2w[i] + 2*k3w[i] + k4w[i]);
+	}
+	return 1;
+}
+
+real getChainEnergy(const Body bodies[], int count, real g) {
+	// E = 0.5mv^2 + mgh, with each bob's velocity and height summed down the chain
+	real vx = 0.0f, vy = 0.0f, h = 0.0f;
+	real kinetic = 0.0f, potential = 0.0f;
+	for (int i = 0; i < count; ++i) {
+		real l = bodies[i].length;
+		real w = bodies[i].omega;
+		vx += l * w * realCos(bodies[i].theta);
+		vy -= l * w * realSin(bodies[i].theta);
+		h += l * (1 - realCos(bodies[i].theta));
+		kinetic += 0.5f * bodies[i].mass * (vx * vx + vy * vy);
+		potential += bodies[i].mass * g * h;
+	}
+	return kinetic + potential;
+}
+
+int solveSystem(Body bodies[], int count, real g, real dt, Integrator integrator) {
+	if (count == 1) {
+		solveSingle(&bodies[0], g, dt, integrator);
+	} else if (count == 2) {
+		solveDouble(&bodies[0], &bodies[1], g, dt, integrator);
+	} else {
+		return solveChain(bodies, count, g, dt, integrator);
+	}
+	return 1;
+}
+
+real getSystemEnergy(const Body bodies[], int count, real g) {
+	if (count == 1) {
+		return getSingleEnergy(bodies[0], g);
+	} else if (count == 2) {
+		return getDoubleEnergy(bodies[0], bodies[1], g);
+	}
+	return getChainEnergy(bodies, count, g);
+}
+
+void packChain(const Body bodies[], int count, real y[]) {
+	for (int i = 0; i < count; ++i) {
+		y[2 * i] = bodies[i].theta;
+		y[2 * i + 1] = bodies[i].omega;
+	}
+}
+
+void unpackChain(const real y[], int count, Body bodies[]) {
+	for (int i = 0; i < count; ++i) {
+		bodies[i].theta = y[2 * i];
+		bodies[i].omega = y[2 * i + 1];
+	}
+}
+
+void chainDerivative(const real y[], real dydt[], const void *params) {
+	const ChainParams *p = (const ChainParams *)params;
+	Body stage[MAX_CHAIN];
+	real alpha[MAX_CHAIN];
+	if (p->count < 1 || p->count > MAX_CHAIN) {
+		// No way to report it from here, the integrator gives up on NaN
+		for (int i = 0; i < 2 * p->count; ++i) {
+			dydt[i] = (real)NAN;
+		}
+		return;
+	}
+	for (int i = 0; i < p->count; ++i) {
+		stage[i] = (Body){p->bodies[i].mass, p->bodies[i].length, y[2 * i], y[2 * i + 1]};
+	}
+	chainAlpha(stage, p->count, p->g, alpha);
+	for (int i = 0; i < p->count; ++i) {
+		dydt[2 * i] = y[2 * i + 1];
+		dydt[2 * i + 1] = alpha[i];
+	}
+}
@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include "include/poincare.h"
+
+#define POINCARE_MIN_CAPACITY 1024
+
+typedef struct PoincareJob {
+	const Body (*bodies)[2];
+	real g;
+	real duration;
+	real tol;
+	PoincareBuffer *buffers; // one per worker
+} PoincareJob;
+
+void pushPoincarePoint(PoincareBuffer *buffer, PoincarePoint point) {
+	if (buffer->count == buffer->capacity) {
+		long long capacity = buffer->capacity ? 2 * buffer->capacity : POINCARE_MIN_CAPACITY;
+		PoincarePoint *grown = realloc(buffer->points, (size_t)capacity * sizeof(PoincarePoint));
+		if (grown == NULL) {
+			return; // out of memory, the point is lost
+		}
+		buffer->points = grown;
+		buffer->capacity = capacity;
+	}
+	buffer->points[buffer->count++] = point;
+}
+
+void freePoincareBuffer(PoincareBuffer *buffer) {
+	free(buffer->points);
+	*buffer = (PoincareBuffer){0};
+}
+
+real poincareEvent(const real y[], const void *ctx) {
+	return realSin(y[0]);
+}
+
+long long sectionDouble(Body body0, Body body1, real g, real duration, real tol,
+						int run, PoincareBuffer *out) {
+	DoubleParams params = getDoubleParams(body0, body1, g);
+	real y[4];
+	Dopri rk;
+	DopriEvent event;
+	long long found = 0;
+
+	packDouble(body0, body1, y);
+	initDopri(&rk, doubleDerivative, &params, y, 4, tol, 0.01f);
+	initDopriEvent(&event, poincareEvent, NULL, 1, &rk);
+	while (rk.t < duration && stepDopri(&rk)) {
+		real t;
+		// sin(theta0) also rises through zero at theta0 = pi going left, which
+		// isn't on the section
+		if (locateDopriEvent(&event, &rk, &t, y) && t <= duration && realCos(y[0]) > 0) {
+			pushPoincarePoint(out, (PoincarePoint){run, (float)t, (float)y[0], (float)y[1],
+				(float)y[2], (float)y[3]});
+			++found;
+		}
+	}
+	return found;
+}
+
+static void poincareChunk(void *ctx, int chunk, int worker) {
+	PoincareJob *job = (PoincareJob *)ctx;
+	sectionDouble(job->bodies[chunk][0], job->bodies[chunk][1], job->g, job->duration,
+				  job->tol, chunk, &job->buffers[worker]);
+}
+
+void runPoincare(JobPool *pool, const Body (*bodies)[2], int count, real g,
+				 real duration, real tol, PoincareBuffer *out) {
+	int workers = getJobPoolSize(pool);
+	PoincareBuffer *buffers = calloc((size_t)workers, sizeof(PoincareBuffer));
+	if (buffers == NULL) {
+		return;
+	}
+	PoincareJob job = {bodies, g, duration, tol, buffers};
+	runJobs(pool, count, poincareChunk, &job);
+
+	// Each worker filled its own buffer without locking, join them at the end
+	for (int w = 0; w < workers; ++w) {
+		for (long long i = 0; i < buffers[w].count; ++i) {
+			pushPoincarePoint(out, buffers[w].points[i]);
+		}
+		freePoincareBuffer(&buffers[w]);
+	}
+	free(buffers);
+}
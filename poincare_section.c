@@ -0,0 +1,104 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/poincare.h"
+
+// Headless Poincare sections, see poincare.h. Reads one double pendulum per
+// line from stdin, in the same format as lyapunov_spectrum,
+//
+//   theta0 theta1 [omega0 omega1 [m0 m1 l0 l1]]
+//
+// and writes every crossing as a CSV row, sorted by run and time.
+//
+//   poincare_section [-t seconds] [-tol tolerance] [-g gravity] [-j threads] < input
+
+#define GRAVITY 9.81f
+#define DURATION 1000.0f
+#define TOLERANCE 1e-8
+// The tightest RK45 tolerance worth asking for in this precision, float
+// builds can't get anywhere near 1e-8
+#define MIN_TOLERANCE (100 * REAL_EPSILON)
+#define INITIAL_CAPACITY 256
+
+static int comparePoints(const void *a, const void *b) {
+	const PoincarePoint *p = a, *q = b;
+	if (p->run != q->run) {
+		return (p->run > q->run) - (p->run < q->run);
+	}
+	return (p->t > q->t) - (p->t < q->t);
+}
+
+int main(int argc, char **argv) {
+	float duration = DURATION;
+	float tol = (float)fmax(TOLERANCE, MIN_TOLERANCE);
+	float g = GRAVITY;
+	int threads = 0;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-t") == 0) {
+			duration = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-tol") == 0) {
+			tol = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-g") == 0) {
+			g = (float)atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			threads = atoi(argv[i + 1]);
+		} else {
+			break;
+		}
+	}
+	if (duration <= 0 || tol <= 0) {
+		fprintf(stderr, "usage: poincare_section [-t seconds] [-tol tolerance] [-g gravity] [-j threads] < input\n");
+		return 1;
+	}
+	if (tol < MIN_TOLERANCE) {
+		fprintf(stderr, "tolerance %g is below what this precision can reach, using %g\n", tol, MIN_TOLERANCE);
+		tol = (float)MIN_TOLERANCE;
+	}
+
+	int count = 0, capacity = INITIAL_CAPACITY;
+	Body (*bodies)[2] = malloc(capacity * sizeof(*bodies));
+	char line[512];
+	while (bodies != NULL && fgets(line, sizeof(line), stdin) != NULL) {
+		double v[8] = {0, 0, 0, 0, 1, 1, 1, 1};
+		int read = sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf",
+			&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+		if (read < 2) {
+			continue; // blank lines and comments
+		}
+		if (count == capacity) {
+			capacity *= 2;
+			void *grown = realloc(bodies, capacity * sizeof(*bodies));
+			if (grown == NULL) {
+				free(bodies);
+				bodies = NULL;
+				break;
+			}
+			bodies = grown;
+		}
+		bodies[count][0] = (Body){(real)v[4], (real)v[6], (real)v[0], (real)v[2]};
+		bodies[count][1] = (Body){(real)v[5], (real)v[7], (real)v[1], (real)v[3]};
+		++count;
+	}
+	JobPool *pool = newJobPool(threads);
+	if (bodies == NULL || pool == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	PoincareBuffer section = {0};
+	runPoincare(pool, (const Body (*)[2])bodies, count, g, duration, tol, &section);
+	qsort(section.points, (size_t)section.count, sizeof(PoincarePoint), comparePoints);
+
+	printf("run,t,theta0,omega0,theta1,omega1\n");
+	for (long long i = 0; i < section.count; ++i) {
+		const PoincarePoint *p = &section.points[i];
+		printf("%d,%.9g,%.9g,%.9g,%.9g,%.9g\n", p->run, p->t, p->theta0, p->omega0, p->theta1, p->omega1);
+	}
+	fprintf(stderr, "%lld crossings from %d runs\n", section.count, count);
+
+	freePoincareBuffer(&section);
+	freeJobPool(pool);
+	free(bodies);
+	return 0;
+}
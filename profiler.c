@@ -0,0 +1,50 @@
+#include "include/profiler.h"
+#include "include/thread.h"
+
+// Only the viewer's main thread ever touches this
+static ProfileFrame history[PROFILE_HISTORY];
+static int head; // slot the current frame goes into
+static int count;
+static ProfileFrame current;
+static double frameStart;
+static double phaseStart[PHASE_COUNT];
+
+const char *getPhaseName(ProfilePhase phase) {
+	switch (phase) {
+		case PHASE_INPUT: return "Input";
+		case PHASE_PHYSICS: return "Physics";
+		case PHASE_UI: return "UI";
+		case PHASE_RENDER: return "Render";
+		default: return "?";
+	}
+}
+
+void profileFrame(void) {
+	double now = getClock();
+	if (frameStart > 0.0) {
+		current.total = (float)(now - frameStart);
+		history[head] = current;
+		head = (head + 1) % PROFILE_HISTORY;
+		if (count < PROFILE_HISTORY) {
+			++count;
+		}
+	}
+	current = (ProfileFrame){0};
+	frameStart = now;
+}
+
+void profileBegin(ProfilePhase phase) {
+	phaseStart[phase] = getClock();
+}
+
+void profileEnd(ProfilePhase phase) {
+	current.phase[phase] += (float)(getClock() - phaseStart[phase]);
+}
+
+const ProfileFrame *getProfileFrame(int n) {
+	return &history[(head - 1 - n + 2 * PROFILE_HISTORY) % PROFILE_HISTORY];
+}
+
+int getProfileFrameCount(void) {
+	return count;
+}
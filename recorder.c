@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "include/trajectory.h"
+#include "include/thread.h"
+
+#define WRITER_IDLE 0.002f // seconds the writer sleeps when the ring is empty
+
+struct Recorder {
+	FILE *file;
+	int bodyCount;
+	size_t frameSize;
+	unsigned char *ring;
+
+	// Single producer (the simulation) and single consumer (the writer), so
+	// each index only ever has one thread writing it
+	Atomic64 head; // frames pushed
+	Atomic64 tail; // frames written to disk
+	Atomic64 dropped;
+	Atomic64 stop;
+	Thread writer;
+};
+
+static void writeSpan(Recorder *rec, long long from, long long to) {
+	long long start = from % RECORDER_RING_FRAMES;
+	long long count = to - from;
+	long long first = RECORDER_RING_FRAMES - start;
+	if (first > count) {
+		first = count;
+	}
+	fwrite(rec->ring + start * rec->frameSize, rec->frameSize, (size_t)first, rec->file);
+	if (count > first) {
+		fwrite(rec->ring, rec->frameSize, (size_t)(count - first), rec->file);
+	}
+}
+
+static void writerMain(void *arg) {
+	Recorder *rec = (Recorder *)arg;
+	long long tail = atomicLoad(&rec->tail);
+	for (;;) {
+		long long head = atomicLoad(&rec->head);
+		if (head == tail) {
+			if (atomicLoad(&rec->stop)) {
+				break;
+			}
+			sleepThread(WRITER_IDLE);
+			continue;
+		}
+		writeSpan(rec, tail, head);
+		tail = head;
+		atomicStore(&rec->tail, tail);
+	}
+	fflush(rec->file);
+}
+
+Recorder *startRecorder(const char *path, const Body bodies[], int bodyCount,
+						float g, float dt, Integrator integrator) {
+	Recorder *rec = calloc(1, sizeof(Recorder));
+	if (rec == NULL) {
+		return NULL;
+	}
+	rec->bodyCount = bodyCount;
+	rec->frameSize = TRAJ_FRAME_SIZE(bodyCount);
+	rec->ring = malloc((size_t)RECORDER_RING_FRAMES * rec->frameSize);
+	rec->file = fopen(path, "wb");
+	if (rec->ring == NULL || rec->file == NULL) {
+		if (rec->file != NULL) fclose(rec->file);
+		free(rec->ring);
+		free(rec);
+		return NULL;
+	}
+
+	TrajHeader header = {
+		.magic = TRAJ_MAGIC,
+		.version = TRAJ_VERSION,
+		.headerSize = (uint32_t)(sizeof(TrajHeader) + 2 * bodyCount * sizeof(float)),
+		.frameSize = (uint32_t)rec->frameSize,
+		.bodyCount = (uint32_t)bodyCount,
+		.integrator = (uint32_t)integrator,
+		.dt = dt,
+		.g = g,
+	};
+	fwrite(&header, sizeof(header), 1, rec->file);
+	// The file is float whatever real is
+	for (int i = 0; i < bodyCount; ++i) {
+		float mass = (float)bodies[i].mass;
+		fwrite(&mass, sizeof(float), 1, rec->file);
+	}
+	for (int i = 0; i < bodyCount; ++i) {
+		float length = (float)bodies[i].length;
+		fwrite(&length, sizeof(float), 1, rec->file);
+	}
+
+	if (!startThread(&rec->writer, writerMain, rec)) {
+		fclose(rec->file);
+		free(rec->ring);
+		free(rec);
+		return NULL;
+	}
+	return rec;
+}
+
+void recordFrame(Recorder *rec, double time, long long step, const Body bodies[], float energy) {
+	long long head = atomicLoad(&rec->head);
+	if (head - atomicLoad(&rec->tail) >= RECORDER_RING_FRAMES) {
+		atomicAdd(&rec->dropped, 1);
+		return;
+	}
+	TrajFrame *frame = (TrajFrame *)(rec->ring + (head % RECORDER_RING_FRAMES) * rec->frameSize);
+	frame->time = time;
+	frame->step = step;
+	frame->energy = energy;
+	frame->unused = 0.0f;
+	for (int i = 0; i < rec->bodyCount; ++i) {
+		frame->bodies[2 * i] = (float)bodies[i].theta;
+		frame->bodies[2 * i + 1] = (float)bodies[i].omega;
+	}
+	atomicStore(&rec->head, head + 1);
+}
+
+void stopRecorder(Recorder *rec) {
+	if (rec == NULL) {
+		return;
+	}
+	atomicStore(&rec->stop, 1);
+	joinThread(rec->writer);
+	fclose(rec->file);
+	free(rec->ring);
+	free(rec);
+}
+
+long long getRecorderFrames(Recorder *rec) {
+	return atomicLoad(&rec->head);
+}
+
+long long getRecorderDropped(Recorder *rec) {
+	return atomicLoad(&rec->dropped);
+}
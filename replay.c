@@ -0,0 +1,182 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <math.h>
+#include "include/trajectory.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void *mapFile(const char *path, long long *size, void **handle) {
+	#if defined(_WIN32)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return NULL;
+	LARGE_INTEGER length;
+	GetFileSizeEx(file, &length);
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) return NULL;
+	void *map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (map == NULL) {
+		CloseHandle(mapping);
+		return NULL;
+	}
+	*size = length.QuadPart;
+	*handle = mapping;
+	return map;
+	#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+	void *map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return NULL;
+	*size = info.st_size;
+	*handle = NULL;
+	return map;
+	#endif
+}
+
+static void unmapFile(void *map, long long size, void *handle) {
+	#if defined(_WIN32)
+	UnmapViewOfFile(map);
+	CloseHandle(handle);
+	#else
+	munmap(map, (size_t)size);
+	#endif
+}
+
+int openTrajectory(Trajectory *traj, const char *path) {
+	*traj = (Trajectory){0};
+	traj->map = mapFile(path, &traj->mapSize, &traj->handle);
+	if (traj->map == NULL) {
+		return 0;
+	}
+
+	const TrajHeader *header = (const TrajHeader *)traj->map;
+	if (traj->mapSize < (long long)sizeof(TrajHeader) || header->magic != TRAJ_MAGIC
+		|| header->version != TRAJ_VERSION || header->bodyCount > MAX_CHAIN
+		|| header->headerSize < sizeof(TrajHeader) + 2 * sizeof(float) * header->bodyCount
+		|| header->headerSize > traj->mapSize || header->headerSize % 8 != 0
+		|| header->frameSize != TRAJ_FRAME_SIZE(header->bodyCount)) {
+		closeTrajectory(traj);
+		return 0;
+	}
+
+	const unsigned char *base = (const unsigned char *)traj->map;
+	traj->header = header;
+	traj->mass = (const float *)(base + sizeof(TrajHeader));
+	traj->length = traj->mass + header->bodyCount;
+	traj->frames = base + header->headerSize;
+	// A trailing partial frame means the recorder was cut off, just ignore it
+	traj->frameCount = (traj->mapSize - header->headerSize) / header->frameSize;
+	return 1;
+}
+
+void closeTrajectory(Trajectory *traj) {
+	if (traj->map != NULL) {
+		unmapFile(traj->map, traj->mapSize, traj->handle);
+	}
+	*traj = (Trajectory){0};
+}
+
+const TrajFrame *getTrajFrame(const Trajectory *traj, long long n) {
+	return (const TrajFrame *)(traj->frames + n * traj->header->frameSize);
+}
+
+void getTrajBodies(const Trajectory *traj, long long n, Body bodies[]) {
+	const TrajFrame *frame = getTrajFrame(traj, n);
+	for (uint32_t i = 0; i < traj->header->bodyCount; ++i) {
+		bodies[i] = (Body){traj->mass[i], traj->length[i], frame->bodies[2 * i], frame->bodies[2 * i + 1]};
+	}
+}
+
+// Is n the last frame at or before time?
+static int isTrajFrameAt(const Trajectory *traj, long long n, double time) {
+	return getTrajFrame(traj, n)->time <= time
+		&& (n + 1 == traj->frameCount || getTrajFrame(traj, n + 1)->time > time);
+}
+
+long long findTrajStep(const Trajectory *traj, long long step) {
+	if (traj->frameCount == 0) {
+		return -1;
+	}
+	const TrajFrame *first = getTrajFrame(traj, 0);
+	if (step <= first->step) {
+		return 0;
+	}
+	// Without drops frame n is step n past the first one
+	long long n = step - first->step;
+	if (n < traj->frameCount && getTrajFrame(traj, n)->step == step) {
+		return n;
+	}
+	long long lo = 0, hi = traj->frameCount - 1;
+	while (lo < hi) {
+		long long mid = lo + (hi - lo + 1) / 2;
+		if (getTrajFrame(traj, mid)->step <= step) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return lo;
+}
+
+long long findTrajFrame(const Trajectory *traj, double time) {
+	if (traj->frameCount == 0) {
+		return -1;
+	}
+	const TrajFrame *first = getTrajFrame(traj, 0);
+	if (time <= first->time) {
+		return 0;
+	}
+	if (traj->header->dt > 0.0f) {
+		long long steps = (long long)floor((time - first->time) / traj->header->dt + 1e-6);
+		long long n = findTrajStep(traj, first->step + steps);
+		if (isTrajFrameAt(traj, n, time)) {
+			return n;
+		}
+	}
+	long long lo = 0, hi = traj->frameCount - 1;
+	while (lo < hi) {
+		long long mid = lo + (hi - lo + 1) / 2;
+		if (getTrajFrame(traj, mid)->time <= time) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return lo;
+}
+
+double getTrajDuration(const Trajectory *traj) {
+	if (traj->frameCount == 0) {
+		return 0.0;
+	}
+	return getTrajFrame(traj, traj->frameCount - 1)->time - getTrajFrame(traj, 0)->time;
+}
+
+// offset is in floats from the energy
+static TrajColumn getColumn(const Trajectory *traj, int offset) {
+	return (TrajColumn){
+		.base = &((const TrajFrame *)traj->frames)->energy + offset,
+		.stride = traj->header->frameSize / sizeof(float),
+		.count = traj->frameCount,
+	};
+}
+
+TrajColumn getTrajEnergy(const Trajectory *traj) { return getColumn(traj, 0); }
+TrajColumn getTrajTheta(const Trajectory *traj, int body) { return getColumn(traj, 2 + 2 * body); }
+TrajColumn getTrajOmega(const Trajectory *traj, int body) { return getColumn(traj, 3 + 2 * body); }
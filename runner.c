@@ -0,0 +1,112 @@
+#include <stddef.h>
+#include "include/runner.h"
+#include "include/dopri.h"
+
+typedef struct RunnerJob {
+	Ensemble *ensemble;
+	float dt;
+	int steps;
+	float duration;
+	float tol;
+	EnsembleEvent event;
+	void *eventCtx;
+	int *stopStep;
+} RunnerJob;
+
+static int getChunkCount(const Ensemble *ensemble) {
+	return (ensemble->count + RUNNER_CHUNK - 1) / RUNNER_CHUNK;
+}
+
+static void fixedChunk(void *ctx, int chunk, int worker) {
+	RunnerJob *job = (RunnerJob *)ctx;
+	int begin = chunk * RUNNER_CHUNK;
+	int end = begin + RUNNER_CHUNK;
+	if (end > job->ensemble->count) {
+		end = job->ensemble->count;
+	}
+	for (int i = 0; i < job->steps; ++i) {
+		stepEnsembleRange(job->ensemble, begin, end, job->dt);
+	}
+}
+
+static void adaptiveChunk(void *ctx, int chunk, int worker) {
+	RunnerJob *job = (RunnerJob *)ctx;
+	Ensemble *e = job->ensemble;
+	int begin = chunk * RUNNER_CHUNK;
+	int end = begin + RUNNER_CHUNK;
+	if (end > e->count) {
+		end = e->count;
+	}
+	for (int i = begin; i < end; ++i) {
+		Body body0, body1;
+		real y[4];
+		Dopri rk;
+		getEnsembleBodies(e, i, &body0, &body1);
+		DoubleParams params = getDoubleParams(body0, body1, e->g);
+		packDouble(body0, body1, y);
+		initDopri(&rk, doubleDerivative, &params, y, 4, job->tol, 0.01f);
+		if (advanceDopri(&rk, job->duration)) {
+			denseDopri(&rk, job->duration, y);
+		} else {
+			y[0] = y[1] = y[2] = y[3] = (real)NAN;
+		}
+		unpackDouble(y, &body0, &body1);
+		setEnsembleBodies(e, i, body0, body1);
+	}
+}
+
+static void untilChunk(void *ctx, int chunk, int worker) {
+	RunnerJob *job = (RunnerJob *)ctx;
+	int begin = chunk * RUNNER_CHUNK;
+	int end = begin + RUNNER_CHUNK;
+	if (end > job->ensemble->count) {
+		end = job->ensemble->count;
+	}
+	runEnsembleRangeUntil(job->ensemble, begin, end, job->dt, job->steps,
+						  job->event, job->eventCtx, job->stopStep);
+}
+
+void runEnsembleRangeUntil(Ensemble *ensemble, int begin, int end, float dt, int steps,
+						   EnsembleEvent event, void *ctx, int stopStep[]) {
+	for (int i = begin; stopStep != NULL && i < end; ++i) {
+		stopStep[ensemble->id[i]] = 0;
+	}
+	int live = compactEnsembleRange(ensemble, begin, end);
+	for (int s = 1; s <= steps && live > begin; ++s) {
+		stepEnsembleRange(ensemble, begin, live, dt);
+		int stopped = 0;
+		for (int i = begin; i < live; ++i) {
+			if (ensemble->active[i] <= 0.0f) {
+				++stopped;
+			} else if (event(ctx, ensemble, i)) {
+				ensemble->active[i] = 0.0f;
+				if (stopStep != NULL) {
+					stopStep[ensemble->id[i]] = s;
+				}
+				++stopped;
+			}
+		}
+		// Squeeze the finished lanes out once they're worth a vector and an
+		// eighth of what's being stepped, so the vectors stay mostly full
+		if (stopped >= ENSEMBLE_LANES && 8 * stopped >= live - begin) {
+			live = compactEnsembleRange(ensemble, begin, live);
+		}
+	}
+}
+
+void runEnsemble(JobPool *pool, Ensemble *ensemble, float dt, int steps) {
+	RunnerJob job = {.ensemble = ensemble, .dt = dt, .steps = steps};
+	runJobs(pool, getChunkCount(ensemble), fixedChunk, &job);
+}
+
+void runEnsembleAdaptive(JobPool *pool, Ensemble *ensemble, float duration, float tol) {
+	RunnerJob job = {.ensemble = ensemble, .duration = duration, .tol = tol};
+	runJobs(pool, getChunkCount(ensemble), adaptiveChunk, &job);
+}
+
+void runEnsembleUntil(JobPool *pool, Ensemble *ensemble, float dt, int steps,
+					  EnsembleEvent event, void *ctx, int stopStep[]) {
+	RunnerJob job = {.ensemble = ensemble, .dt = dt, .steps = steps,
+		.event = event, .eventCtx = ctx, .stopStep = stopStep};
+	runJobs(pool, getChunkCount(ensemble), untilChunk, &job);
+}
@@ -0,0 +1,396 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/scenario.h"
+
+#define DEFAULT_G 9.81f
+#define DEFAULT_DT (1.0f / 240.0f)
+#define PATH_LEN 256
+
+struct ScenarioFile {
+	FILE *file;
+	char *buffer; // SCENARIO_BUFFER + 1, for the terminator of a last line without a newline
+	size_t start; // first byte not handed out yet
+	size_t end;
+	int eof;
+	int tooLong;
+	long long line;
+	int columnCount;
+	char path[PATH_LEN];
+};
+
+static const char *const fieldNames[] = {"g", "mass", "length", "theta", "omega"};
+
+static void complain(const ScenarioFile *file, const char *why, const char *what) {
+	fprintf(stderr, "%s:%lld: %s%s%s\n", file->path, file->line, why,
+		what != NULL ? " " : "", what != NULL ? what : "");
+}
+
+// The next line with its comment cut off, NULL at the end of the file or
+// when a line doesn't fit in the buffer. Lines are terminated in place.
+static char *nextLine(ScenarioFile *file) {
+	for (;;) {
+		char *from = file->buffer + file->start;
+		char *newline = memchr(from, '\n', file->end - file->start);
+		if (newline == NULL && file->eof && file->start == file->end) {
+			return NULL;
+		}
+		if (newline != NULL || file->eof) {
+			char *last = newline != NULL ? newline : file->buffer + file->end;
+			*last = '\0';
+			file->start = (size_t)(last - file->buffer) + (newline != NULL);
+			file->line++;
+			char *comment = strchr(from, '#');
+			if (comment != NULL) {
+				*comment = '\0';
+			}
+			return from;
+		}
+		if (file->start == 0 && file->end == SCENARIO_BUFFER) {
+			file->tooLong = 1;
+			return NULL;
+		}
+		memmove(file->buffer, from, file->end - file->start);
+		file->end -= file->start;
+		file->start = 0;
+		size_t read = fread(file->buffer + file->end, 1, SCENARIO_BUFFER - file->end, file->file);
+		file->end += read;
+		file->eof = read == 0;
+	}
+}
+
+// Splits off the next whitespace separated word, NULL if there isn't one
+static char *nextWord(char **cursor) {
+	char *c = *cursor;
+	while (isspace((unsigned char)*c)) {
+		c++;
+	}
+	if (*c == '\0') {
+		*cursor = c;
+		return NULL;
+	}
+	char *word = c;
+	while (*c != '\0' && !isspace((unsigned char)*c)) {
+		c++;
+	}
+	if (*c != '\0') {
+		*c++ = '\0';
+	}
+	*cursor = c;
+	return word;
+}
+
+// Plain decimals like 0.25, -3 or 1.5e-3 with up to 15 significant digits
+// are exact as one multiply or divide by a power of ten, which is several
+// times faster than strtod. Anything else goes to strtod. Returns the end of
+// the number, or c itself if there isn't one.
+static const char *scanNumber(const char *c, double *value) {
+	static const double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	const char *start = c;
+	while (*c == ' ' || *c == '\t') {
+		c++;
+	}
+	int negative = *c == '-';
+	c += *c == '-' || *c == '+';
+	unsigned long long mantissa = 0;
+	int digits = 0, exponent = 0;
+	for (; *c >= '0' && *c <= '9'; ++c, ++digits) {
+		mantissa = mantissa * 10 + (unsigned long long)(*c - '0');
+	}
+	if (*c == '.') {
+		for (++c; *c >= '0' && *c <= '9'; ++c, ++digits, --exponent) {
+			mantissa = mantissa * 10 + (unsigned long long)(*c - '0');
+		}
+	}
+	if (*c == 'e' || *c == 'E') {
+		const char *e = c + 1;
+		int negativeE = *e == '-';
+		e += *e == '-' || *e == '+';
+		int power = 0;
+		if (*e < '0' || *e > '9') {
+			digits = 0; // "1e" with nothing after, let strtod decide
+		}
+		for (; *e >= '0' && *e <= '9' && power < 1000; ++e) {
+			power = power * 10 + (*e - '0');
+		}
+		exponent += negativeE ? -power : power;
+		c = e;
+	}
+	char next = *c;
+	int boundary = next == '\0' || isspace((unsigned char)next);
+	if (digits == 0 || digits > 15 || exponent < -22 || exponent > 22 || !boundary) {
+		char *end;
+		*value = strtod(start, &end);
+		return end;
+	}
+	double v = (double)mantissa;
+	v = exponent < 0 ? v / powers[-exponent] : v * powers[exponent];
+	*value = negative ? -v : v;
+	return c;
+}
+
+static int parseReal(const char *word, real *value) {
+	double v;
+	const char *end = scanNumber(word, &v);
+	if (end == word || *end != '\0') {
+		return 0;
+	}
+	*value = (real)v;
+	return 1;
+}
+
+static int parseInt(const char *word, int *value) {
+	char *end;
+	long v = strtol(word, &end, 10);
+	if (end == word || *end != '\0' || v < 0 || v > 1 << 30) {
+		return 0;
+	}
+	*value = (int)v;
+	return 1;
+}
+
+// "RK4", "rk4", "Yoshida4" and "yoshida4" all name RK4 or YOSHIDA4
+static int parseIntegrator(const char *word, Integrator *integrator) {
+	for (int i = 0; i < INTEGRATOR_COUNT; ++i) {
+		const char *name = getIntegratorName((Integrator)i);
+		const char *w = word;
+		for (; *name != '\0'; ++name) {
+			if (*name == ' ') {
+				continue;
+			}
+			if (tolower((unsigned char)*name) != tolower((unsigned char)*w)) {
+				break;
+			}
+			w++;
+		}
+		if (*name == '\0' && *w == '\0') {
+			*integrator = (Integrator)i;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int parseParam(const char *word, int count, ScenarioParam *param) {
+	if (strcmp(word, "g") == 0) {
+		*param = (ScenarioParam){SCENARIO_G, 0};
+		return 1;
+	}
+	for (int f = SCENARIO_MASS; f <= SCENARIO_OMEGA; ++f) {
+		size_t len = strlen(fieldNames[f]);
+		int body;
+		if (strncmp(word, fieldNames[f], len) == 0 && parseInt(word + len, &body) && body < count) {
+			*param = (ScenarioParam){(ScenarioField)f, body};
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// One line of settings. Returns 1 if it was fine, 2 if it was the runs line
+// and 0 (after complaining) if it wasn't fine.
+static int parseSetting(ScenarioFile *file, char *line, Scenario *scenario) {
+	char *cursor = line;
+	char *key = nextWord(&cursor);
+	if (key == NULL) {
+		return 1;
+	}
+	if (strcmp(key, "runs") == 0) {
+		scenario->columnCount = 0;
+		for (char *word; (word = nextWord(&cursor)) != NULL;) {
+			if (scenario->columnCount == SCENARIO_MAX_COLUMNS) {
+				complain(file, "too many columns", NULL);
+				return 0;
+			}
+			if (!parseParam(word, scenario->count, &scenario->columns[scenario->columnCount++])) {
+				complain(file, "unknown parameter", word);
+				return 0;
+			}
+		}
+		if (scenario->columnCount == 0) {
+			complain(file, "runs needs at least one column", NULL);
+			return 0;
+		}
+		return 2;
+	}
+
+	char *words[4];
+	int n = 0;
+	while (n < 4 && (words[n] = nextWord(&cursor)) != NULL) {
+		n++;
+	}
+	if (nextWord(&cursor) != NULL) {
+		complain(file, "too many values for", key);
+		return 0;
+	}
+
+	real v[4] = {0, 0, 0, 0};
+	int numbers = 0;
+	if (strcmp(key, "g") == 0 && n == 1 && parseReal(words[0], &v[0])) {
+		scenario->g = v[0];
+	} else if (strcmp(key, "dt") == 0 && n == 1 && parseReal(words[0], &v[0]) && v[0] > 0) {
+		scenario->dt = (float)v[0];
+	} else if (strcmp(key, "integrator") == 0 && n == 1) {
+		if (!parseIntegrator(words[0], &scenario->integrator)) {
+			complain(file, "unknown integrator", words[0]);
+			return 0;
+		}
+	} else if (strcmp(key, "body") == 0 && (n == 3 || n == 4)) {
+		while (numbers < n && parseReal(words[numbers], &v[numbers])) {
+			numbers++;
+		}
+		if (numbers < n || v[0] <= 0 || v[1] <= 0) {
+			complain(file, "body needs a positive mass and length, an angle and maybe a speed", NULL);
+			return 0;
+		}
+		if (scenario->count == SCENARIO_MAX_BODIES) {
+			complain(file, "too many bodies", NULL);
+			return 0;
+		}
+		scenario->bodies[scenario->count++] = (Body){v[0], v[1], v[2], v[3]};
+	} else if (strcmp(key, "ensemble") == 0 && n == 2 && parseInt(words[0], &scenario->ensembleSide)
+			   && parseReal(words[1], &v[0])) {
+		scenario->ensembleSpread = (float)v[0];
+	} else if (strcmp(key, "vary") == 0 && n == 4) {
+		ScenarioAxis axis;
+		if (!parseParam(words[0], scenario->count, &axis.param)) {
+			complain(file, "unknown parameter", words[0]);
+			return 0;
+		}
+		if (!parseReal(words[1], &axis.min) || !parseReal(words[2], &axis.max)
+			|| !parseInt(words[3], &axis.count) || axis.count < 1) {
+			complain(file, "vary needs a parameter, min, max and count", NULL);
+			return 0;
+		}
+		if (scenario->axisCount == SCENARIO_MAX_AXES) {
+			complain(file, "too many vary lines", NULL);
+			return 0;
+		}
+		scenario->axes[scenario->axisCount++] = axis;
+	} else {
+		complain(file, "can't read", key);
+		return 0;
+	}
+	return 1;
+}
+
+ScenarioFile *openScenario(const char *path, Scenario *scenario) {
+	ScenarioFile *file = calloc(1, sizeof(ScenarioFile));
+	if (file == NULL) {
+		return NULL;
+	}
+	snprintf(file->path, sizeof(file->path), "%s", path);
+	file->file = fopen(path, "rb");
+	file->buffer = malloc(SCENARIO_BUFFER + 1);
+	if (file->file == NULL || file->buffer == NULL) {
+		fprintf(stderr, "couldn't open %s\n", path);
+		closeScenario(file);
+		return NULL;
+	}
+
+	memset(scenario, 0, sizeof(*scenario));
+	scenario->g = DEFAULT_G;
+	scenario->dt = DEFAULT_DT;
+	scenario->integrator = RK4;
+	int parsed = 1;
+	char *line;
+	while (parsed == 1 && (line = nextLine(file)) != NULL) {
+		parsed = parseSetting(file, line, scenario);
+	}
+	if (file->tooLong) {
+		complain(file, "line too long", NULL);
+		parsed = 0;
+	}
+	if (parsed != 0 && scenario->count == 0) {
+		complain(file, "no bodies", NULL);
+		parsed = 0;
+	}
+	if (parsed == 0) {
+		closeScenario(file);
+		return NULL;
+	}
+	file->columnCount = scenario->columnCount;
+	return file;
+}
+
+int readScenarioRun(ScenarioFile *file, real values[]) {
+	if (file->columnCount == 0) {
+		return 0;
+	}
+	char *line;
+	while ((line = nextLine(file)) != NULL) {
+		const char *cursor = line;
+		while (isspace((unsigned char)*cursor)) {
+			cursor++;
+		}
+		if (*cursor == '\0') {
+			continue;
+		}
+		for (int c = 0; c < file->columnCount; ++c) {
+			double v;
+			const char *end = scanNumber(cursor, &v);
+			if (end == cursor) {
+				complain(file, "expected a number", NULL);
+				return -1;
+			}
+			values[c] = (real)v;
+			cursor = end;
+		}
+		while (isspace((unsigned char)*cursor)) {
+			cursor++;
+		}
+		if (*cursor != '\0') {
+			complain(file, "too many values", NULL);
+			return -1;
+		}
+		return 1;
+	}
+	if (file->tooLong) {
+		complain(file, "line too long", NULL);
+		return -1;
+	}
+	return 0;
+}
+
+long long getScenarioLine(const ScenarioFile *file) {
+	return file->line;
+}
+
+void closeScenario(ScenarioFile *file) {
+	if (file == NULL) {
+		return;
+	}
+	if (file->file != NULL) {
+		fclose(file->file);
+	}
+	free(file->buffer);
+	free(file);
+}
+
+int loadScenario(const char *path, Scenario *scenario) {
+	ScenarioFile *file = openScenario(path, scenario);
+	closeScenario(file);
+	return file != NULL;
+}
+
+void setScenarioParam(Body bodies[], real *g, ScenarioParam param, real value) {
+	switch (param.field) {
+		case SCENARIO_G: *g = value; break;
+		case SCENARIO_MASS: bodies[param.body].mass = value; break;
+		case SCENARIO_LENGTH: bodies[param.body].length = value; break;
+		case SCENARIO_THETA: bodies[param.body].theta = value; break;
+		case SCENARIO_OMEGA: bodies[param.body].omega = value; break;
+	}
+}
+
+void getScenarioParamName(ScenarioParam param, char name[16]) {
+	if (param.field == SCENARIO_G) {
+		snprintf(name, 16, "g");
+	} else {
+		snprintf(name, 16, "%s%d", fieldNames[param.field], param.body);
+	}
+}
@@ -0,0 +1,506 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/simthread.h"
+#include "include/dopri.h"
+#include "include/thread.h"
+#include "include/trace.h"
+
+#define SLOT_FRESH 4 // set in middle when there's a state the renderer hasn't taken
+#define BUDGET_CHECK 16 // fixed steps between looks at the clock
+#define COST_SMOOTHING 0.1 // weight of the newest batch in the per-step cost
+
+// What's waiting in SimThread's mailbox
+#define COMMAND_RUNNING 1
+#define COMMAND_SPEED 2
+#define COMMAND_INTEGRATOR 4
+#define COMMAND_RESET 8
+#define COMMAND_RECORDER 16
+
+typedef struct SimCommands {
+	int pending; // COMMAND_ flags
+	int running;
+	float speedup;
+	Integrator integrator;
+	Body bodies[SIM_MAX_BODIES];
+	Recorder *recorder;
+	long long posted; // commands posted so far
+} SimCommands;
+
+struct SimThread {
+	// Only touched by the physics thread
+	Body bodies[SIM_MAX_BODIES];
+	Body prev[SIM_MAX_BODIES];
+	int count;
+	real g;
+	double time;
+	long long steps;
+	int stepsLast;
+	FixedStep clock;
+	Integrator chosen; // what the user asked for
+	Integrator integrator; // what's stepping, see nextWarpIntegrator
+	float speedup;
+	int running;
+	Recorder *recorder;
+
+	// The newest path points, point n at n % SIM_PATH_POINTS, see SimFrame
+	float pathX[SIM_PATH_POINTS];
+	float pathY[SIM_PATH_POINTS];
+	long long pathTotal; // points so far
+	long long pathPublished; // pathEnd of the last frame published
+	long long pathTaken; // pathEnd of the last frame the renderer is known to have
+	double pathNext; // RK45 steps are too long for a smooth path, it gets a point every dt
+
+	// RK45 integrates the whole state in one Dopri. Its time is kept relative
+	// to dopriBase, which moves up every batch so float never has to hold
+	// the whole run.
+	Dopri dopri;
+	double dopriBase;
+	SingleParams singleParams;
+	DoubleParams doubleParams;
+	ChainParams chainParams;
+
+	// Time warp bookkeeping
+	double stepCost[INTEGRATOR_COUNT]; // seconds per fixed step, 0 until measured
+	int behindBatches;
+	int relaxBatches;
+	double windowWall;
+	double windowSim;
+	double windowBusy;
+	double windowBudget;
+	float warp;
+	float load;
+
+	// Triple buffer, back belongs to the physics thread and front to the renderer
+	SimFrame slots[3];
+	int back;
+	int front;
+	Atomic64 middle; // slot index, plus SLOT_FRESH
+
+	// Settings from the render thread. They're posted here under the mutex
+	// and the physics thread picks them up between batches, so neither side
+	// holds the lock for longer than a copy.
+	Mutex *mutex;
+	SimCommands commands;
+	Recorder *recorderSet; // the last one posted, what setSimRecorder hands back
+	Atomic64 applied; // commands.posted as of the last pickup
+
+	Atomic64 stop;
+	Thread thread;
+};
+
+static int canUseDopri(const SimThread *sim) {
+	return 2 * sim->count <= DOPRI_MAX_DIM;
+}
+
+static int usesDopri(const SimThread *sim) {
+	return sim->integrator == RK45 && canUseDopri(sim);
+}
+
+// The next integrator up when the current one can't keep up with the warp
+static Integrator nextWarpIntegrator(const SimThread *sim, Integrator integrator) {
+	if ((integrator == YOSHIDA4 || integrator == YOSHIDA6) && sim->count <= 2) {
+		return VERLET;
+	}
+	if (integrator != RK45 && canUseDopri(sim)) {
+		return RK45;
+	}
+	return integrator;
+}
+
+static void initSimDopri(SimThread *sim) {
+	real y[DOPRI_MAX_DIM];
+	Derivative f;
+	const void *params;
+	if (sim->count == 1) {
+		sim->singleParams = (SingleParams){sim->bodies[0].length, sim->g};
+		f = singleDerivative;
+		params = &sim->singleParams;
+	} else if (sim->count == 2) {
+		sim->doubleParams = getDoubleParams(sim->bodies[0], sim->bodies[1], sim->g);
+		f = doubleDerivative;
+		params = &sim->doubleParams;
+	} else {
+		sim->chainParams = (ChainParams){sim->bodies, sim->count, sim->g};
+		f = chainDerivative;
+		params = &sim->chainParams;
+	}
+	packChain(sim->bodies, sim->count, y);
+	initDopri(&sim->dopri, f, params, y, 2 * sim->count, SIM_RK45_TOL, sim->clock.dt);
+	sim->dopriBase = sim->time;
+	sim->pathNext = sim->time + sim->clock.dt;
+}
+
+static void useIntegrator(SimThread *sim, Integrator integrator) {
+	sim->integrator = integrator;
+	if (usesDopri(sim)) {
+		initSimDopri(sim);
+	}
+	sim->behindBatches = 0;
+	sim->relaxBatches = 0;
+}
+
+static void pushSimPath(SimThread *sim, const Body bodies[]) {
+	float x = 0.0f, y = 0.0f;
+	for (int i = 0; i < sim->count; ++i) {
+		x += (float)(bodies[i].length * realSin(bodies[i].theta));
+		y += (float)(bodies[i].length * realCos(bodies[i].theta));
+	}
+	sim->pathX[sim->pathTotal % SIM_PATH_POINTS] = x;
+	sim->pathY[sim->pathTotal % SIM_PATH_POINTS] = y;
+	sim->pathTotal++;
+}
+
+static void recordSim(SimThread *sim) {
+	if (sim->recorder != NULL) {
+		recordFrame(sim->recorder, sim->time, sim->steps, sim->bodies, getSystemEnergy(sim->bodies, sim->count, sim->g));
+	}
+}
+
+static void stepSim(SimThread *sim) {
+	memcpy(sim->prev, sim->bodies, sim->count * sizeof(Body));
+	solveSystem(sim->bodies, sim->count, sim->g, sim->clock.dt, sim->integrator);
+	sim->time += sim->clock.dt;
+	sim->steps++;
+	pushSimPath(sim, sim->bodies);
+	recordSim(sim);
+}
+
+// Path points every dt through the last Dopri step, up to end past dopriBase
+static void pathSimDopri(SimThread *sim, real end) {
+	Dopri *rk = &sim->dopri;
+	real y[DOPRI_MAX_DIM];
+	double last = sim->dopriBase + realMin(rk->t, end);
+	for (; sim->pathNext <= last; sim->pathNext += sim->clock.dt) {
+		denseDopri(rk, (real)(sim->pathNext - sim->dopriBase), y);
+		unpackChain(y, sim->count, sim->prev); // only scratch until the batch ends
+		pushSimPath(sim, sim->prev);
+	}
+}
+
+// Adaptive steps up to delta past the current time, interpolated to exactly
+// where it ends. Each accepted step is recorded as it's taken, and the path
+// gets points every dt along it. Returns 0 if the deadline cut it short.
+static int advanceSimDopri(SimThread *sim, real delta, double deadline) {
+	Dopri *rk = &sim->dopri;
+	real shift = (real)(sim->time - sim->dopriBase);
+	rk->t -= shift;
+	rk->tPrev -= shift;
+	sim->dopriBase = sim->time;
+
+	int accepted = rk->accepted;
+	int onTime = 1;
+	pathSimDopri(sim, delta); // what's left of the step the last batch ended in
+	real end = delta;
+	while (rk->t < end) {
+		if (getClock() > deadline) {
+			end = rk->t;
+			onTime = 0;
+			break;
+		}
+		if (!stepDopri(rk)) {
+			// Nothing more to get out of this state, hold it until a reset
+			end = rk->t;
+			sim->running = 0;
+			break;
+		}
+		pathSimDopri(sim, delta);
+		if (sim->recorder != NULL) {
+			// Every accepted step goes in at its own time, the interpolated
+			// end of the batch doesn't. prev is only scratch until the end.
+			unpackChain(rk->y, sim->count, sim->prev);
+			recordFrame(sim->recorder, sim->dopriBase + rk->t, sim->steps + rk->accepted - accepted,
+						sim->prev, getSystemEnergy(sim->prev, sim->count, sim->g));
+		}
+	}
+
+	real y[DOPRI_MAX_DIM];
+	denseDopri(rk, end, y);
+	unpackChain(y, sim->count, sim->bodies);
+	memcpy(sim->prev, sim->bodies, sim->count * sizeof(Body));
+	sim->time = sim->dopriBase + end;
+	sim->stepsLast = rk->accepted - accepted;
+	sim->steps += sim->stepsLast;
+	return onTime;
+}
+
+// Moves up the ladder when the warp has been out of reach for a while, and
+// back down once the chosen integrator would fit again
+static void adaptWarpIntegrator(SimThread *sim, int onTime) {
+	sim->behindBatches = onTime ? 0 : sim->behindBatches + 1;
+	if (sim->behindBatches >= SIM_SWITCH_BATCHES) {
+		Integrator next = nextWarpIntegrator(sim, sim->integrator);
+		if (next != sim->integrator) {
+			useIntegrator(sim, next);
+		}
+		sim->behindBatches = 0;
+		return;
+	}
+
+	double cost = sim->stepCost[sim->chosen];
+	if (sim->integrator == sim->chosen || cost <= 0.0) {
+		sim->relaxBatches = 0;
+		return;
+	}
+	double predicted = sim->speedup / sim->clock.dt * cost / SIM_BUDGET;
+	sim->relaxBatches = (predicted < SIM_RELAX_LOAD) ? sim->relaxBatches + 1 : 0;
+	if (sim->relaxBatches >= SIM_SWITCH_BATCHES) {
+		useIntegrator(sim, sim->chosen);
+	}
+}
+
+// Takes however much simulated time is due after elapsed seconds of wall
+// time, or as much of it as fits in the budget
+static void advanceSim(SimThread *sim, float elapsed) {
+	sim->stepsLast = 0;
+	if (!sim->running) {
+		sim->warp = 0.0f;
+		sim->load = 0.0f;
+		sim->windowWall = sim->windowSim = sim->windowBusy = sim->windowBudget = 0.0;
+		return;
+	}
+	elapsed = fminf(elapsed, MAX_FRAME_TIME);
+	double start = getClock();
+	double budget = SIM_BUDGET * fmax(elapsed, SIM_IDLE);
+	double deadline = start + budget;
+	double timeBefore = sim->time;
+	int onTime = 1;
+
+	if (usesDopri(sim)) {
+		onTime = advanceSimDopri(sim, elapsed * sim->speedup, deadline);
+	} else {
+		int steps = advanceFixedStep(&sim->clock, elapsed, sim->speedup);
+		int taken = 0;
+		for (; taken < steps; ++taken) {
+			if (taken % BUDGET_CHECK == 0 && taken > 0 && getClock() > deadline) {
+				// Whatever's left is dropped, like the step cap used to
+				onTime = 0;
+				break;
+			}
+			TRACE_BEGIN("step");
+			stepSim(sim);
+			TRACE_END("step");
+		}
+		sim->stepsLast = taken;
+		if (taken >= BUDGET_CHECK) {
+			double cost = (getClock() - start) / taken;
+			double *old = &sim->stepCost[sim->integrator];
+			*old = (*old > 0.0) ? *old + COST_SMOOTHING * (cost - *old) : cost;
+		}
+	}
+	double busy = getClock() - start;
+	TRACE_COUNTER("steps per batch", sim->stepsLast);
+
+	sim->windowWall += elapsed;
+	sim->windowSim += sim->time - timeBefore;
+	sim->windowBusy += busy;
+	sim->windowBudget += SIM_BUDGET * elapsed;
+	if (sim->windowWall >= SIM_WARP_WINDOW) {
+		sim->warp = (float)(sim->windowSim / sim->windowWall);
+		sim->load = (float)(sim->windowBusy / sim->windowBudget);
+		sim->windowWall = sim->windowSim = sim->windowBusy = sim->windowBudget = 0.0;
+		TRACE_COUNTER("warp", sim->warp);
+	}
+	adaptWarpIntegrator(sim, onTime);
+}
+
+static void publishSim(SimThread *sim) {
+	SimFrame *frame = &sim->slots[sim->back];
+	frame->time = sim->time;
+	frame->steps = sim->steps;
+	frame->stepsLast = sim->stepsLast;
+	frame->speedup = sim->speedup;
+	frame->warp = sim->warp;
+	frame->load = sim->load;
+	frame->integrator = sim->integrator;
+	frame->alpha = usesDopri(sim) ? 1.0f : getFixedStepAlpha(sim->clock);
+	frame->count = sim->count;
+	memcpy(frame->prev, sim->prev, sim->count * sizeof(Body));
+	memcpy(frame->bodies, sim->bodies, sim->count * sizeof(Body));
+	// Everything since the last frame the renderer took, as far as the ring goes
+	long long first = sim->pathTotal - SIM_PATH_POINTS;
+	if (first < sim->pathTaken) {
+		first = sim->pathTaken;
+	}
+	for (long long n = first; n < sim->pathTotal; ++n) {
+		frame->pathX[n - first] = sim->pathX[n % SIM_PATH_POINTS];
+		frame->pathY[n - first] = sim->pathY[n % SIM_PATH_POINTS];
+	}
+	frame->pathEnd = sim->pathTotal;
+	frame->pathCount = (int)(sim->pathTotal - first);
+	long long old = atomicExchange(&sim->middle, sim->back | SLOT_FRESH);
+	sim->back = (int)(old & ~SLOT_FRESH);
+	if (!(old & SLOT_FRESH)) {
+		// The last one went out, so the next frame can start where it ended
+		sim->pathTaken = sim->pathPublished;
+	}
+	sim->pathPublished = sim->pathTotal;
+}
+
+static void takeSimCommands(SimThread *sim) {
+	lockMutex(sim->mutex);
+	SimCommands *c = &sim->commands;
+	if (c->pending & COMMAND_RUNNING) {
+		if (c->running && !sim->running) {
+			// Don't make up for the time spent stopped
+			sim->clock.accumulator = 0.0f;
+		}
+		sim->running = c->running;
+	}
+	if (c->pending & COMMAND_SPEED) {
+		sim->speedup = c->speedup;
+	}
+	if (c->pending & COMMAND_INTEGRATOR) {
+		sim->chosen = c->integrator;
+	}
+	if (c->pending & COMMAND_RESET) {
+		memcpy(sim->bodies, c->bodies, sim->count * sizeof(Body));
+		memcpy(sim->prev, c->bodies, sim->count * sizeof(Body));
+		sim->time = 0.0;
+		sim->steps = 0;
+		sim->clock.accumulator = 0.0f;
+	}
+	if (c->pending & (COMMAND_INTEGRATOR | COMMAND_RESET)) {
+		useIntegrator(sim, sim->chosen);
+	}
+	if (c->pending & COMMAND_RECORDER) {
+		sim->recorder = c->recorder;
+	}
+	c->pending = 0;
+	atomicStore(&sim->applied, c->posted);
+	unlockMutex(sim->mutex);
+}
+
+// Leaves the command for the physics thread, returns its ticket
+static long long postSimCommand(SimThread *sim, int command) {
+	sim->commands.pending |= command;
+	return ++sim->commands.posted;
+}
+
+static void simMain(void *arg) {
+	SimThread *sim = (SimThread *)arg;
+	setTraceThreadName("physics");
+	double last = getClock();
+	while (!atomicLoad(&sim->stop)) {
+		double now = getClock();
+		float elapsed = (float)(now - last);
+		last = now;
+
+		takeSimCommands(sim);
+		TRACE_BEGIN("physics");
+		advanceSim(sim, elapsed);
+		publishSim(sim);
+		TRACE_END("physics");
+		// Sleep until the next step is due, the accumulator keeps the rate
+		// right whenever the sleep overshoots
+		float wait = SIM_IDLE;
+		if (sim->running && !usesDopri(sim) && sim->speedup > 0.0f) {
+			wait = (sim->clock.dt - sim->clock.accumulator) / sim->speedup;
+		}
+
+		if (wait > SIM_IDLE) {
+			wait = SIM_IDLE;
+		}
+		if (wait > 0.0f) {
+			sleepThread(wait);
+		} else {
+			yieldThread();
+		}
+	}
+}
+
+SimThread *startSimThread(const Body bodies[], int count, real g, float dt, Integrator integrator) {
+	if (count < 1 || count > SIM_MAX_BODIES) {
+		return NULL;
+	}
+	SimThread *sim = calloc(1, sizeof(SimThread));
+	if (sim == NULL) {
+		return NULL;
+	}
+	memcpy(sim->bodies, bodies, count * sizeof(Body));
+	memcpy(sim->prev, bodies, count * sizeof(Body));
+	sim->count = count;
+	sim->g = g;
+	// No step cap, the time budget is what stops a batch
+	sim->clock = newFixedStep(dt, INT_MAX);
+	sim->chosen = integrator;
+	sim->speedup = 1.0f;
+	sim->back = 0;
+	sim->front = 1;
+	atomicStore(&sim->middle, 2);
+	useIntegrator(sim, integrator);
+	// Something to read before the physics thread gets going
+	publishSim(sim);
+
+	sim->mutex = newMutex();
+	if (sim->mutex == NULL) {
+		free(sim);
+		return NULL;
+	}
+	if (!startThread(&sim->thread, simMain, sim)) {
+		freeMutex(sim->mutex);
+		free(sim);
+		return NULL;
+	}
+	return sim;
+}
+
+void stopSimThread(SimThread *sim) {
+	if (sim == NULL) {
+		return;
+	}
+	atomicStore(&sim->stop, 1);
+	joinThread(sim->thread);
+	freeMutex(sim->mutex);
+	free(sim);
+}
+
+const SimFrame *readSimFrame(SimThread *sim) {
+	if (atomicLoad(&sim->middle) & SLOT_FRESH) {
+		sim->front = (int)(atomicExchange(&sim->middle, sim->front) & ~SLOT_FRESH);
+	}
+	return &sim->slots[sim->front];
+}
+
+void setSimRunning(SimThread *sim, int running) {
+	lockMutex(sim->mutex);
+	sim->commands.running = running;
+	postSimCommand(sim, COMMAND_RUNNING);
+	unlockMutex(sim->mutex);
+}
+
+void setSimSpeed(SimThread *sim, float speedup) {
+	lockMutex(sim->mutex);
+	sim->commands.speedup = speedup;
+	postSimCommand(sim, COMMAND_SPEED);
+	unlockMutex(sim->mutex);
+}
+
+void setSimIntegrator(SimThread *sim, Integrator integrator) {
+	lockMutex(sim->mutex);
+	sim->commands.integrator = integrator;
+	postSimCommand(sim, COMMAND_INTEGRATOR);
+	unlockMutex(sim->mutex);
+}
+
+void resetSim(SimThread *sim, const Body bodies[]) {
+	lockMutex(sim->mutex);
+	memcpy(sim->commands.bodies, bodies, sim->count * sizeof(Body));
+	postSimCommand(sim, COMMAND_RESET);
+	unlockMutex(sim->mutex);
+}
+
+Recorder *setSimRecorder(SimThread *sim, Recorder *recorder) {
+	lockMutex(sim->mutex);
+	Recorder *old = sim->recorderSet;
+	sim->recorderSet = recorder;
+	sim->commands.recorder = recorder;
+	long long ticket = postSimCommand(sim, COMMAND_RECORDER);
+	unlockMutex(sim->mutex);
+	// The old one may still be in use until the current batch ends
+	while (atomicLoad(&sim->applied) < ticket) {
+		sleepThread(SIM_IDLE / 4);
+	}
+	return old;
+}
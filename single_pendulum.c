@@ -1,27 +1,22 @@
 #include <math.h>
+#include <stdio.h>
 #include "include/raylib.h"
 #include "include/raymath.h"
+#include "include/pendulum.h"
+#include "include/simthread.h"
+#include "include/trajectory.h"
 
 #define GRAVITY (200.0f) // this just worked best
 #define RADIUS 32
-#define MAX_SPEED 16.0f
+#define MAX_SPEED 131072.0f // time warp, see include/simthread.h
 #define MIN_SPEED 0.0625f
-#define ONE_SIXTH 0.16666667f
 
-#define RK4 1 // 1: use Runge-Kutta 4, 0: use forward Euler
-
-typedef struct Body {
-	float mass;
-	float length;
-	float theta;
-	float omega;
-} Body;
+#define INTEGRATOR RK4 // starting integrator, I cycles through the rest
+#define PHYSICS_DT (1.0f / 240.0f)
+#define RECORD_PATH "single_pendulum.traj"
 
 void render(Body body, Vector2 origin);
-void solve(Body *body, float dt);
 Vector2 getPos(Body body);
-float func(float theta, float length); // f in dx/dt = f(x, t) in numerical integration
-float getEnergy(Body body);
 
 int main(void) {
 	const Vector2 screenSize = {1280, 720};
@@ -37,57 +32,93 @@ int main(void) {
 
 	Body pendulum = (Body){10, 300, 0.4f * PI, 0};
 
-	/*
-	FILE *pendulumData;
-	fopen_s(&pendulumData, "output.txt", "w");
-	*/
-	float initialEnergy = getEnergy(pendulum);
+	// Steps on its own thread at its own rate, so vsync doesn't hold it back
+	SimThread *sim = startSimThread(&pendulum, 1, GRAVITY, PHYSICS_DT, INTEGRATOR);
+	if (sim == NULL) {
+		CloseWindow();
+		return 1;
+	}
+	setSimRunning(sim, 1);
+
+	Recorder *recorder = NULL;
+
+	real initialEnergy = getSingleEnergy(pendulum, GRAVITY);
+	Integrator integrator = INTEGRATOR;
 
 	while (!WindowShouldClose()) {
-		float dt = GetFrameTime();
 		KeyboardKey key = GetKeyPressed();
 
 		if (key == KEY_RIGHT && speedup < MAX_SPEED) {
 			speedup *= 2.0f;
+			setSimSpeed(sim, speedup);
 		} else if (key == KEY_LEFT && speedup > MIN_SPEED) {
 			speedup *= 0.5f;
+			setSimSpeed(sim, speedup);
+		}
+
+		if (key == KEY_I) {
+			integrator = (integrator + 1) % INTEGRATOR_COUNT;
+			setSimIntegrator(sim, integrator);
 		}
 
-		// Numerically integrate to solve the system according to the
-		// differential equation given by the Euler-Lagrange equation
-		if (speedup > 1.0f - EPSILON) {
-			int steps = (int)(speedup + EPSILON);
-			for (int i = 0; i < steps; ++i) {
-				solve(&pendulum, dt);
+		if (key == KEY_R) {
+			if (recorder == NULL) {
+				recorder = startRecorder(RECORD_PATH, &pendulum, 1, GRAVITY, integrator == RK45 ? 0.0f : PHYSICS_DT, integrator);
+				setSimRecorder(sim, recorder);
+			} else {
+				stopRecorder(setSimRecorder(sim, NULL));
+				recorder = NULL;
 			}
-		} else {
-			solve(&pendulum, dt * speedup);
 		}
-		float energy = getEnergy(pendulum);
+
+		// The physics thread numerically integrates the differential
+		// equation given by the Euler-Lagrange equation with a fixed step, so
+		// this only has to pick up the latest state it has published
+		const SimFrame *frame = readSimFrame(sim);
+		pendulum = frame->bodies[0];
+		real energy = getSingleEnergy(pendulum, GRAVITY);
 
 		BeginDrawing();
 
 		ClearBackground(BLACK);
 
 		// Draw the system
-		render(pendulum, origin);
+		render(interpolateBody(frame->prev[0], pendulum, frame->alpha), origin);
 
 		// Speedup text
 		const char *speedupText = (speedup >= 1 - EPSILON)
 			? TextFormat("Speed: %dX", (int)speedup)
 			: TextFormat("Speed: 1/%dX", (int)(1.0f / speedup));
 		DrawText(speedupText, 0.5f * (GetScreenWidth() - MeasureText(speedupText, 36)), 120, 36, WHITE);
+		if (frame->warp > 0.0f && frame->warp < 0.99f * frame->speedup) {
+			// The physics thread couldn't fit the requested warp in its budget
+			const char *warpText = TextFormat("achieved %.0fX", frame->warp);
+			DrawText(warpText, 0.5f * (GetScreenWidth() - MeasureText(warpText, 24)), 160, 24, YELLOW);
+		}
 
 		//Energy text;
 		DrawText(TextFormat("Initial energy: %f", initialEnergy), 20, 20, 24, WHITE);
 		DrawText(TextFormat("Current energy: %f", energy), 20, 60, 24, WHITE);
-		float percentDiff = 100.0f * (energy - initialEnergy) / initialEnergy;
+		real percentDiff = 100.0f * (energy - initialEnergy) / initialEnergy;
 		DrawText(TextFormat("Energy change: %f%%", percentDiff), 20, 100, 24, WHITE);
+		if (frame->integrator != integrator) {
+			DrawText(TextFormat("Integrator: %s (I), %s for the warp", getIntegratorName(integrator),
+				getIntegratorName(frame->integrator)), 20, 140, 24, YELLOW);
+		} else {
+			DrawText(TextFormat("Integrator: %s (I)", getIntegratorName(integrator)), 20, 140, 24, WHITE);
+		}
+		if (recorder != NULL) {
+			DrawText(TextFormat("Recording: %lld frames, %lld dropped (R)", getRecorderFrames(recorder),
+				getRecorderDropped(recorder)), 20, 180, 24, RED);
+		} else {
+			DrawText("Record (R)", 20, 180, 24, WHITE);
+		}
 
 		EndDrawing();
 	}
 
-	//fclose(pendulumData);
+	stopSimThread(sim);
+	stopRecorder(recorder);
 
 	CloseWindow();
 
@@ -101,45 +132,9 @@ void render(Body body, Vector2 origin) {
 	DrawCircleV(pos, RADIUS, BLUE);
 }
 
-void solve(Body *body, float dt) {
-	#if RK4
-
-	float omegaDot1 = func(body->theta, body->length);
-	float thetaDot1 = body->omega;
-	float omegaDot2 = func(body->theta + 0.5f * dt * thetaDot1, body->length);
-	float thetaDot2 = body->omega + 0.5f * dt * omegaDot1;
-	float omegaDot3 = func(body->theta + 0.5f * dt * thetaDot2, body->length);
-	float thetaDot3 = body->omega + 0.5f * dt * omegaDot2;
-	float omegaDot4 = func(body->theta + dt * thetaDot3, body->length);
-	float thetaDot4 = body->omega + dt * omegaDot3;
-
-	body->omega += ONE_SIXTH * dt * (omegaDot1 + 2*omegaDot2 + 2*omegaDot3 + omegaDot4);
-	body->theta += ONE_SIXTH * dt * (thetaDot1 + 2*thetaDot2 + 2*thetaDot3 + thetaDot4);
-
-	#else
-	
-	body->theta += dt * body->omega;
-	body->omega += dt * func(body->theta, body->length);
-
-	#endif
-
-	return;
-}
-
 Vector2 getPos(Body body) {
 	return Vector2Scale((Vector2){
 		sinf(body.theta), 
 		cosf(body.theta)
 	}, body.length);
 }
-
-float func(float theta, float length) {
-	return - (GRAVITY / length) * sinf(theta);
-}
-
-float getEnergy(Body body) {
-	// E = 0.5mv^2 + mgh
-	float kinetic = 0.5f * body.mass * body.length * body.length * body.omega * body.omega;
-	float potential = body.mass * GRAVITY * body.length * (1 - cosf(body.theta));
-	return kinetic + potential;
-}
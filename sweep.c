@@ -0,0 +1,140 @@
+#include <math.h>
+#include <stdlib.h>
+#include "include/sweep.h"
+#include "include/lyapunov.h"
+
+#define PI 3.14159265358979323846
+
+// Which turn around the pivot an arm is on. It changes by one every time the
+// arm goes over the top, the same |theta| > pi the flip map uses.
+static long long getTurn(real theta) {
+	return (long long)floor((theta + PI) / (2 * PI));
+}
+
+SweepMetrics measureRun(Body body0, Body body1, real g, float dt, Integrator integrator, float duration) {
+	SweepMetrics metrics = {0, 0, SWEEP_NO_FLIP, 0};
+	Lyapunov lyapunov;
+	initLyapunov(&lyapunov, body0, body1, g);
+	real energy = getDoubleEnergy(body0, body1, g);
+	real scale = (energy != 0) ? (real)fabs(energy) : 1;
+	long long turn0 = getTurn(body0.theta), turn1 = getTurn(body1.theta);
+
+	int steps = (int)(duration / dt + 0.5f);
+	for (int s = 1; s <= steps; ++s) {
+		stepLyapunov(&lyapunov, dt);
+		if (integrator == RK4) {
+			getLyapunovBodies(&lyapunov, &body0, &body1); // the same trajectory, no need to step it twice
+		} else {
+			solveDouble(&body0, &body1, g, dt, integrator);
+		}
+
+		real drift = (real)fabs(getDoubleEnergy(body0, body1, g) - energy) / scale;
+		if (!isfinite(drift)) {
+			metrics.maxDrift = (real)INFINITY; // blew up, nothing after this means anything
+			break;
+		}
+		if (drift > metrics.maxDrift) {
+			metrics.maxDrift = drift;
+		}
+
+		long long t0 = getTurn(body0.theta), t1 = getTurn(body1.theta);
+		int flips = (int)(llabs(t0 - turn0) + llabs(t1 - turn1));
+		if (flips > 0 && metrics.flips == 0) {
+			metrics.firstFlip = s * dt;
+		}
+		metrics.flips += flips;
+		turn0 = t0;
+		turn1 = t1;
+	}
+
+	real spectrum[LYAPUNOV_DIM];
+	getLyapunovSpectrum(&lyapunov, spectrum);
+	metrics.lyapunov = spectrum[0];
+	return metrics;
+}
+
+static void sweepRun(void *ctx, int run, int worker) {
+	const Sweep *sweep = (const Sweep *)ctx;
+	Body bodies[2] = {sweep->body0, sweep->body1};
+	real g = sweep->g;
+	const real *values = sweep->values + (size_t)run * sweep->paramCount;
+	for (int p = 0; p < sweep->paramCount; ++p) {
+		setScenarioParam(bodies, &g, sweep->params[p], values[p]);
+	}
+	sweep->metrics[run] = measureRun(bodies[0], bodies[1], g, sweep->dt, sweep->integrator, sweep->duration);
+}
+
+void runSweep(JobPool *pool, const Sweep *sweep) {
+	// Runs take about as long as each other, so one job each balances fine
+	runJobs(pool, sweep->count, sweepRun, (void *)sweep);
+}
+
+long long getCartesianCount(const ScenarioAxis axes[], int axisCount) {
+	long long count = 1;
+	for (int a = 0; a < axisCount; ++a) {
+		if (count > (1LL << 62) / axes[a].count) {
+			return -1;
+		}
+		count *= axes[a].count;
+	}
+	return count;
+}
+
+static real getAxisValue(const ScenarioAxis *axis, double u) {
+	return (real)(axis->min + (axis->max - axis->min) * u);
+}
+
+void getCartesianRun(const ScenarioAxis axes[], int axisCount, long long index, real values[]) {
+	for (int a = axisCount - 1; a >= 0; --a) {
+		int k = (int)(index % axes[a].count);
+		index /= axes[a].count;
+		values[a] = getAxisValue(&axes[a], axes[a].count > 1 ? (double)k / (axes[a].count - 1) : 0.0);
+	}
+}
+
+// splitmix64, so any run can be drawn on its own without stepping a generator
+static unsigned long long mix(unsigned long long x) {
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+int newLatinHypercube(LatinHypercube *lhs, const ScenarioAxis axes[], int axisCount,
+					  int samples, unsigned long long seed) {
+	*lhs = (LatinHypercube){.axisCount = axisCount, .samples = samples, .seed = seed};
+	lhs->strata = malloc((size_t)axisCount * samples * sizeof(int));
+	if (lhs->strata == NULL) {
+		return 0;
+	}
+	for (int a = 0; a < axisCount; ++a) {
+		lhs->axes[a] = axes[a];
+		int *strata = lhs->strata + (size_t)a * samples;
+		for (int i = 0; i < samples; ++i) {
+			strata[i] = i;
+		}
+		unsigned long long state = mix(seed ^ (0xA5A5A5A5ULL * (a + 1)));
+		for (int i = samples - 1; i > 0; --i) {
+			int j = (int)(mix(state++) % (unsigned long long)(i + 1));
+			int t = strata[i];
+			strata[i] = strata[j];
+			strata[j] = t;
+		}
+	}
+	return 1;
+}
+
+void getLatinHypercubeRun(const LatinHypercube *lhs, long long index, real values[]) {
+	for (int a = 0; a < lhs->axisCount; ++a) {
+		// Anywhere inside the stratum, not just its middle
+		unsigned long long h = mix(lhs->seed + mix((unsigned long long)index * SCENARIO_MAX_AXES + a));
+		double jitter = (double)(h >> 11) / 9007199254740992.0;
+		int stratum = lhs->strata[(size_t)a * lhs->samples + index];
+		values[a] = getAxisValue(&lhs->axes[a], (stratum + jitter) / lhs->samples);
+	}
+}
+
+void freeLatinHypercube(LatinHypercube *lhs) {
+	free(lhs->strata);
+	lhs->strata = NULL;
+}
@@ -0,0 +1,146 @@
+#include "include/symplectic.h"
+
+// Triple jump weights, w1 = 1 / (2 - 2^(1/(order+1))) and w0 = 1 - 2 * w1
+#define YOSHIDA4_W1 ((real)1.3512071919596578)
+#define YOSHIDA4_W0 ((real)-1.7024143839193155)
+#define YOSHIDA6_W1 ((real)1.1746717580893635)
+#define YOSHIDA6_W0 ((real)-1.349343516178727)
+
+void verletSingle(Body *body, real g, real dt) {
+	body->omega += 0.5f * dt * singleAlpha(*body, g);
+	body->theta += dt * body->omega;
+	body->omega += 0.5f * dt * singleAlpha(*body, g);
+}
+
+// Generalized coordinates and momenta of the double pendulum
+typedef struct Phase {
+	real t0, t1;
+	real p0, p1;
+} Phase;
+
+// omega = M(theta)^-1 p
+static void getVelocity(const DoubleParams *p, real t0, real t1, real p0, real p1,
+						real *w0, real *w1) {
+	real c = realCos(t0 - t1);
+	real m00 = (p->m0 + p->m1) * p->l0 * p->l0;
+	real m01 = p->m1 * p->l0 * p->l1 * c;
+	real m11 = p->m1 * p->l1 * p->l1;
+	real det = m00 * m11 - m01 * m01;
+	*w0 = (m11 * p0 - m01 * p1) / det;
+	*w1 = (m00 * p1 - m01 * p0) / det;
+}
+
+// dH/dtheta, holding p fixed
+static void getForce(const DoubleParams *p, real t0, real t1, real p0, real p1,
+					 real *f0, real *f1) {
+	real w0, w1;
+	getVelocity(p, t0, t1, p0, p1, &w0, &w1);
+	evalReal coupling = p->m1 * p->l0 * p->l1 * evalSin((evalReal)(t0 - t1)) * w0 * w1;
+	*f0 = coupling + (p->m0 + p->m1) * p->g * p->l0 * evalSin((evalReal)t0);
+	*f1 = -coupling + p->m1 * p->g * p->l1 * evalSin((evalReal)t1);
+}
+
+static int converged(real prev, real next) {
+	return realAbs(next - prev) <= VERLET_TOL * (1.0f + realAbs(next));
+}
+
+static void leapfrog(const DoubleParams *p, Phase *x, real dt) {
+	real h = 0.5f * dt;
+	real f0, f1;
+
+	// p(1/2) = p - h dH/dq(q, p(1/2))
+	getForce(p, x->t0, x->t1, x->p0, x->p1, &f0, &f1);
+	real p0 = x->p0 - h * f0;
+	real p1 = x->p1 - h * f1;
+	for (int i = 0; i < VERLET_MAX_ITER; ++i) {
+		getForce(p, x->t0, x->t1, p0, p1, &f0, &f1);
+		real next0 = x->p0 - h * f0;
+		real next1 = x->p1 - h * f1;
+		int done = converged(p0, next0) && converged(p1, next1);
+		p0 = next0;
+		p1 = next1;
+		if (done) break;
+	}
+
+	// q(1) = q + h (dH/dp(q, p(1/2)) + dH/dp(q(1), p(1/2)))
+	real v0, v1, u0, u1;
+	getVelocity(p, x->t0, x->t1, p0, p1, &v0, &v1);
+	real t0 = x->t0 + dt * v0;
+	real t1 = x->t1 + dt * v1;
+	for (int i = 0; i < VERLET_MAX_ITER; ++i) {
+		getVelocity(p, t0, t1, p0, p1, &u0, &u1);
+		real next0 = x->t0 + h * (v0 + u0);
+		real next1 = x->t1 + h * (v1 + u1);
+		int done = converged(t0, next0) && converged(t1, next1);
+		t0 = next0;
+		t1 = next1;
+		if (done) break;
+	}
+
+	// p(1) = p(1/2) - h dH/dq(q(1), p(1/2))
+	getForce(p, t0, t1, p0, p1, &f0, &f1);
+	x->t0 = t0;
+	x->t1 = t1;
+	x->p0 = p0 - h * f0;
+	x->p1 = p1 - h * f1;
+}
+
+static Phase toPhase(const DoubleParams *p, Body body0, Body body1) {
+	real c = realCos(body0.theta - body1.theta);
+	return (Phase){
+		.t0 = body0.theta,
+		.t1 = body1.theta,
+		.p0 = (p->m0 + p->m1) * p->l0 * p->l0 * body0.omega + p->m1 * p->l0 * p->l1 * c * body1.omega,
+		.p1 = p->m1 * p->l1 * p->l1 * body1.omega + p->m1 * p->l0 * p->l1 * c * body0.omega,
+	};
+}
+
+static void fromPhase(const DoubleParams *p, Phase x, Body *body0, Body *body1) {
+	body0->theta = x.t0;
+	body1->theta = x.t1;
+	getVelocity(p, x.t0, x.t1, x.p0, x.p1, &body0->omega, &body1->omega);
+}
+
+void verletDouble(Body *body0, Body *body1, real g, real dt) {
+	DoubleParams p = getDoubleParams(*body0, *body1, g);
+	Phase x = toPhase(&p, *body0, *body1);
+	leapfrog(&p, &x, dt);
+	fromPhase(&p, x, body0, body1);
+}
+
+// The 4th order method is Verlet with steps w1, w0, w1 and the 6th order one
+// is the 4th order method with the same pattern on top
+static void composeSingle(Body *body, real g, real dt, int order) {
+	if (order <= 2) {
+		verletSingle(body, g, dt);
+		return;
+	}
+	real w1 = (order == 4) ? YOSHIDA4_W1 : YOSHIDA6_W1;
+	real w0 = (order == 4) ? YOSHIDA4_W0 : YOSHIDA6_W0;
+	composeSingle(body, g, w1 * dt, order - 2);
+	composeSingle(body, g, w0 * dt, order - 2);
+	composeSingle(body, g, w1 * dt, order - 2);
+}
+
+static void composeDouble(const DoubleParams *p, Phase *x, real dt, int order) {
+	if (order <= 2) {
+		leapfrog(p, x, dt);
+		return;
+	}
+	real w1 = (order == 4) ? YOSHIDA4_W1 : YOSHIDA6_W1;
+	real w0 = (order == 4) ? YOSHIDA4_W0 : YOSHIDA6_W0;
+	composeDouble(p, x, w1 * dt, order - 2);
+	composeDouble(p, x, w0 * dt, order - 2);
+	composeDouble(p, x, w1 * dt, order - 2);
+}
+
+void yoshidaSingle(Body *body, real g, real dt, int order) {
+	composeSingle(body, g, dt, order);
+}
+
+void yoshidaDouble(Body *body0, Body *body1, real g, real dt, int order) {
+	DoubleParams p = getDoubleParams(*body0, *body1, g);
+	Phase x = toPhase(&p, *body0, *body1);
+	composeDouble(&p, &x, dt, order);
+	fromPhase(&p, x, body0, body1);
+}
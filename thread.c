@@ -0,0 +1,173 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdlib.h>
+#include "include/thread.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+typedef struct ThreadStart {
+	void (*fn)(void *arg);
+	void *arg;
+} ThreadStart;
+
+#if defined(_WIN32)
+
+struct Mutex { SRWLOCK lock; };
+struct Cond { CONDITION_VARIABLE cond; };
+
+static DWORD WINAPI threadMain(LPVOID param) {
+	ThreadStart start = *(ThreadStart *)param;
+	free(param);
+	start.fn(start.arg);
+	return 0;
+}
+
+int startThread(Thread *thread, void (*fn)(void *arg), void *arg) {
+	ThreadStart *start = malloc(sizeof(ThreadStart));
+	if (start == NULL) return 0;
+	*start = (ThreadStart){fn, arg};
+	thread->handle = CreateThread(NULL, 0, threadMain, start, 0, NULL);
+	if (thread->handle == NULL) {
+		free(start);
+		return 0;
+	}
+	return 1;
+}
+
+void joinThread(Thread thread) {
+	WaitForSingleObject(thread.handle, INFINITE);
+	CloseHandle(thread.handle);
+}
+
+void yieldThread(void) {
+	SwitchToThread();
+}
+
+void sleepThread(float seconds) {
+	Sleep((DWORD)(seconds * 1000.0f));
+}
+
+int getCpuCount(void) {
+	return (int)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+}
+
+double getClock(void) {
+	LARGE_INTEGER now, frequency;
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&frequency);
+	return (double)now.QuadPart / (double)frequency.QuadPart;
+}
+
+Mutex *newMutex(void) {
+	Mutex *mutex = malloc(sizeof(Mutex));
+	if (mutex != NULL) InitializeSRWLock(&mutex->lock);
+	return mutex;
+}
+void freeMutex(Mutex *mutex) { free(mutex); }
+void lockMutex(Mutex *mutex) { AcquireSRWLockExclusive(&mutex->lock); }
+void unlockMutex(Mutex *mutex) { ReleaseSRWLockExclusive(&mutex->lock); }
+
+Cond *newCond(void) {
+	Cond *cond = malloc(sizeof(Cond));
+	if (cond != NULL) InitializeConditionVariable(&cond->cond);
+	return cond;
+}
+void freeCond(Cond *cond) { free(cond); }
+void waitCond(Cond *cond, Mutex *mutex) {
+	SleepConditionVariableSRW(&cond->cond, &mutex->lock, INFINITE, 0);
+}
+void signalCond(Cond *cond) { WakeConditionVariable(&cond->cond); }
+void broadcastCond(Cond *cond) { WakeAllConditionVariable(&cond->cond); }
+
+#else
+
+struct Mutex { pthread_mutex_t lock; };
+struct Cond { pthread_cond_t cond; };
+
+static void *threadMain(void *param) {
+	ThreadStart start = *(ThreadStart *)param;
+	free(param);
+	start.fn(start.arg);
+	return NULL;
+}
+
+int startThread(Thread *thread, void (*fn)(void *arg), void *arg) {
+	ThreadStart *start = malloc(sizeof(ThreadStart));
+	pthread_t *handle = malloc(sizeof(pthread_t));
+	if (start == NULL || handle == NULL) {
+		free(start);
+		free(handle);
+		return 0;
+	}
+	*start = (ThreadStart){fn, arg};
+	if (pthread_create(handle, NULL, threadMain, start) != 0) {
+		free(start);
+		free(handle);
+		return 0;
+	}
+	thread->handle = handle;
+	return 1;
+}
+
+void joinThread(Thread thread) {
+	pthread_join(*(pthread_t *)thread.handle, NULL);
+	free(thread.handle);
+}
+
+void yieldThread(void) {
+	sched_yield();
+}
+
+void sleepThread(float seconds) {
+	struct timespec ts;
+	ts.tv_sec = (time_t)seconds;
+	ts.tv_nsec = (long)((seconds - (float)ts.tv_sec) * 1e9f);
+	nanosleep(&ts, NULL);
+}
+
+int getCpuCount(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
+double getClock(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+Mutex *newMutex(void) {
+	Mutex *mutex = malloc(sizeof(Mutex));
+	if (mutex != NULL) pthread_mutex_init(&mutex->lock, NULL);
+	return mutex;
+}
+void freeMutex(Mutex *mutex) {
+	pthread_mutex_destroy(&mutex->lock);
+	free(mutex);
+}
+void lockMutex(Mutex *mutex) { pthread_mutex_lock(&mutex->lock); }
+void unlockMutex(Mutex *mutex) { pthread_mutex_unlock(&mutex->lock); }
+
+Cond *newCond(void) {
+	Cond *cond = malloc(sizeof(Cond));
+	if (cond != NULL) pthread_cond_init(&cond->cond, NULL);
+	return cond;
+}
+void freeCond(Cond *cond) {
+	pthread_cond_destroy(&cond->cond);
+	free(cond);
+}
+void waitCond(Cond *cond, Mutex *mutex) { pthread_cond_wait(&cond->cond, &mutex->lock); }
+void signalCond(Cond *cond) { pthread_cond_signal(&cond->cond); }
+void broadcastCond(Cond *cond) { pthread_cond_broadcast(&cond->cond); }
+
+#endif
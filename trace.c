@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/trace.h"
+#include "include/thread.h"
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+#define TRACE_NAME_LEN 32
+
+typedef struct TraceEvent {
+	const char *name;
+	double ts; // microseconds since startTrace
+	double value; // counters only
+	char phase; // 'B', 'E' or 'C', as in the trace format
+} TraceEvent;
+
+typedef struct TraceBuffer {
+	Atomic64 count; // events written, stored after each one is filled in
+	Atomic64 dropped;
+	int tid;
+	char name[TRACE_NAME_LEN];
+	TraceEvent events[TRACE_BUFFER_EVENTS];
+} TraceBuffer;
+
+volatile int traceEnabled = 0;
+
+static TraceBuffer *buffers[TRACE_MAX_THREADS];
+static Atomic64 bufferCount;
+static double traceStart;
+
+static THREAD_LOCAL TraceBuffer *local;
+static THREAD_LOCAL char localName[TRACE_NAME_LEN];
+
+static TraceBuffer *getLocalBuffer(void) {
+	if (local != NULL) {
+		return local;
+	}
+	long long slot = atomicAdd(&bufferCount, 1);
+	if (slot >= TRACE_MAX_THREADS) {
+		return NULL; // too many threads, this one goes untraced
+	}
+	TraceBuffer *buffer = calloc(1, sizeof(TraceBuffer));
+	if (buffer == NULL) {
+		return NULL;
+	}
+	buffer->tid = (int)slot;
+	if (localName[0] != '\0') {
+		memcpy(buffer->name, localName, TRACE_NAME_LEN);
+	} else {
+		snprintf(buffer->name, TRACE_NAME_LEN, "thread %d", (int)slot);
+	}
+	buffers[slot] = buffer;
+	local = buffer;
+	return buffer;
+}
+
+static void push(char phase, const char *name, double value) {
+	TraceBuffer *buffer = getLocalBuffer();
+	if (buffer == NULL) {
+		return;
+	}
+	long long n = atomicLoad(&buffer->count);
+	if (n >= TRACE_BUFFER_EVENTS) {
+		atomicAdd(&buffer->dropped, 1);
+		return;
+	}
+	buffer->events[n] = (TraceEvent){name, (getClock() - traceStart) * 1e6, value, phase};
+	atomicStore(&buffer->count, n + 1);
+}
+
+void traceBegin(const char *name) {
+	push('B', name, 0.0);
+}
+
+void traceEnd(const char *name) {
+	push('E', name, 0.0);
+}
+
+void traceCounter(const char *name, double value) {
+	push('C', name, value);
+}
+
+void setTraceThreadName(const char *name) {
+	snprintf(localName, TRACE_NAME_LEN, "%s", name);
+	if (local != NULL) {
+		memcpy(local->name, localName, TRACE_NAME_LEN);
+	}
+}
+
+static int getBufferCount(void) {
+	long long count = atomicLoad(&bufferCount);
+	return (int)(count < TRACE_MAX_THREADS ? count : TRACE_MAX_THREADS);
+}
+
+void startTrace(void) {
+	for (int i = 0; i < getBufferCount(); ++i) {
+		if (buffers[i] != NULL) {
+			atomicStore(&buffers[i]->count, 0);
+			atomicStore(&buffers[i]->dropped, 0);
+		}
+	}
+	traceStart = getClock();
+	traceEnabled = 1;
+}
+
+long long getTraceDropped(void) {
+	long long dropped = 0;
+	for (int i = 0; i < getBufferCount(); ++i) {
+		if (buffers[i] != NULL) {
+			dropped += atomicLoad(&buffers[i]->dropped);
+		}
+	}
+	return dropped;
+}
+
+long long stopTrace(const char *path) {
+	traceEnabled = 0;
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		return -1;
+	}
+
+	long long written = 0;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"pendulum\"}}");
+	for (int i = 0; i < getBufferCount(); ++i) {
+		TraceBuffer *buffer = buffers[i];
+		if (buffer == NULL) {
+			continue;
+		}
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			buffer->tid, buffer->name);
+		// Only events below the published count are known to be complete
+		long long count = atomicLoad(&buffer->count);
+		for (long long n = 0; n < count; ++n) {
+			const TraceEvent *e = &buffer->events[n];
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+				e->name, e->phase, e->ts, buffer->tid);
+			if (e->phase == 'C') {
+				fprintf(file, ",\"args\":{\"value\":%.9g}", e->value);
+			}
+			fprintf(file, "}");
+		}
+		written += count;
+	}
+	fprintf(file, "\n]}\n");
+	return (fclose(file) == 0) ? written : -1;
+}
@@ -1,3 +1,5 @@
+#include <math.h>
+#include <stdlib.h>
 #include "include/ui.h"
 #include "include/raylib.h"
 #include "include/raymath.h"
@@ -122,3 +124,93 @@ void handleButton(Button* button, void *state) {
 		button->isPressed = true;
 	}
 }
+
+static Color getPhaseColor(int phase) {
+	static const Color colors[PHASE_COUNT] = {YELLOW, RED, SKYBLUE, GREEN};
+	return (phase < PHASE_COUNT) ? colors[phase] : DARKGRAY; // past the end is the rest of the frame
+}
+
+void drawProfiler(int posX, int posY) {
+	int width = PROFILE_HISTORY * PROFILER_BAR;
+	int frames = getProfileFrameCount();
+	float average[PHASE_COUNT + 1] = {0};
+
+	DrawRectangle(posX, posY, width, PROFILER_HEIGHT, Fade(BLACK, 0.6f));
+	for (int n = 0; n < frames; ++n) {
+		const ProfileFrame *frame = getProfileFrame(n);
+		int x = posX + width - (n + 1) * PROFILER_BAR;
+		float bottom = posY + PROFILER_HEIGHT;
+		float rest = frame->total;
+		for (int p = 0; p <= PHASE_COUNT; ++p) {
+			float seconds = (p < PHASE_COUNT) ? frame->phase[p] : fmaxf(rest, 0.0f);
+			float height = fminf(seconds / PROFILER_SCALE * PROFILER_HEIGHT, bottom - posY);
+			DrawRectangle(x, (int)(bottom - height), PROFILER_BAR, (int)ceilf(height), getPhaseColor(p));
+			bottom -= height;
+			if (p < PHASE_COUNT) {
+				rest -= seconds;
+			}
+			average[p] += seconds / frames;
+		}
+	}
+	// 60 fps line
+	int budget = posY + PROFILER_HEIGHT - (int)(PROFILER_HEIGHT / 60.0f / PROFILER_SCALE);
+	DrawLine(posX, budget, posX + width, budget, WHITE);
+
+	int textX = posX;
+	for (int p = 0; p <= PHASE_COUNT; ++p) {
+		const char *text = TextFormat("%s %.2f ms", (p < PHASE_COUNT) ? getPhaseName(p) : "Other",
+			1000.0f * average[p]);
+		DrawText(text, textX, posY - 24, 20, getPhaseColor(p));
+		textX += MeasureText(text, 20) + 16;
+	}
+}
+
+Trail newTrail(int capacity, Color color) {
+	return (Trail){malloc(2 * (size_t)capacity * sizeof(Vector2)), capacity, 0, 0, color};
+}
+
+void freeTrail(Trail *trail) {
+	free(trail->points);
+	trail->points = NULL;
+	trail->count = 0;
+}
+
+void clearTrail(Trail *trail) {
+	trail->head = 0;
+	trail->count = 0;
+}
+
+void pushTrail(Trail *trail, Vector2 point) {
+	if (trail->points == NULL) {
+		return;
+	}
+	if (trail->count > 0) {
+		int last = (trail->head + trail->capacity - 1) % trail->capacity;
+		if (Vector2Distance(trail->points[last], point) < TRAIL_MIN_STEP) {
+			return;
+		}
+	}
+	trail->points[trail->head] = point;
+	trail->points[trail->head + trail->capacity] = point;
+	trail->head = (trail->head + 1) % trail->capacity;
+	if (trail->count < trail->capacity) {
+		trail->count++;
+	}
+}
+
+void drawTrail(Trail trail) {
+	if (trail.count < 2) {
+		return;
+	}
+	// Oldest to newest, all in a row thanks to the second copy
+	Vector2 *points = trail.points + trail.head + trail.capacity - trail.count;
+	for (int band = 0; band < TRAIL_BANDS; ++band) {
+		// Neighbouring bands share their end point so the strip has no gaps
+		int begin = (int)((long long)(trail.count - 1) * band / TRAIL_BANDS);
+		int end = (int)((long long)(trail.count - 1) * (band + 1) / TRAIL_BANDS);
+		if (end > begin) {
+			float alpha = (float)(band + 1) / TRAIL_BANDS;
+			DrawLineStrip(points + begin, end - begin + 1, Fade(trail.color, alpha));
+		}
+	}
+}